@@ -1,10 +1,85 @@
 #pragma once
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
 
 using SlipHandler = void(*)(char*, size_t);
 
-template<SlipHandler handler, size_t Buff = 256>
+// Frame header preceding every message body.
+// Legacy: u32 id, u16 type, u16 flags (little endian, 8 bytes).
+// Compact: [more:1 | req:1 | type:6] [type >> 6 varint, if more] [id varint, if req]
+struct FrameHeader {
+    static constexpr uint16_t Request = 1;
+    static constexpr size_t MaxSize = 8;
+
+    uint32_t id;
+    uint16_t type;
+    uint16_t flags;
+
+    // Returns header size, 0 on error
+    size_t Parse(bool compact, const char* data, size_t size) noexcept {
+        if (!compact) {
+            if (size < 8) return 0;
+            memcpy(&id, data, 4);
+            memcpy(&type, data + 4, 2);
+            memcpy(&flags, data + 6, 2);
+            return 8;
+        }
+        if (!size) return 0;
+        uint8_t first = data[0];
+        size_t pos = 1;
+        uint32_t rest = 0;
+        type = first & 0x3F;
+        flags = first & 0x40 ? Request : 0;
+        id = 0;
+        if (first & 0x80) {
+            if (!(pos = readVarint(data, size, pos, rest)) || rest > (0xFFFF >> 6)) return 0;
+            type |= rest << 6;
+        }
+        if (flags & Request) {
+            pos = readVarint(data, size, pos, id);
+        }
+        return pos;
+    }
+    // buff must fit MaxSize
+    size_t Dump(bool compact, char* buff) const noexcept {
+        if (!compact) {
+            memcpy(buff, &id, 4);
+            memcpy(buff + 4, &type, 2);
+            memcpy(buff + 6, &flags, 2);
+            return 8;
+        }
+        size_t pos = 1;
+        buff[0] = char((type & 0x3F) | (flags & Request ? 0x40 : 0) | (type > 0x3F ? 0x80 : 0));
+        if (type > 0x3F) {
+            pos = writeVarint(buff, pos, type >> 6);
+        }
+        if (flags & Request) {
+            pos = writeVarint(buff, pos, id);
+        }
+        return pos;
+    }
+private:
+    static size_t readVarint(const char* data, size_t size, size_t pos, uint32_t& out) noexcept {
+        out = 0;
+        for (uint8_t shift = 0; pos < size && shift < 32; shift += 7) {
+            uint8_t b = data[pos++];
+            out |= uint32_t(b & 0x7F) << shift;
+            if (!(b & 0x80)) return pos;
+        }
+        return 0;
+    }
+    static size_t writeVarint(char* buff, size_t pos, uint32_t val) noexcept {
+        while (val > 0x7F) {
+            buff[pos++] = char((val & 0x7F) | 0x80);
+            val >>= 7;
+        }
+        buff[pos++] = char(val);
+        return pos;
+    }
+};
+
+template<SlipHandler handler, size_t Buff = 256, size_t TxBuff = 256>
 struct Slip {
     static constexpr char END = char(0xC0);
     static constexpr char ESC = char(0xDB);
@@ -54,31 +129,68 @@ public:
             handleChar(ch);
         }
     }
-    static void Write(const char* data, size_t size) {
-        size_t av = Serial.availableForWrite();
-        for (size_t i = 0; i < size; ++i) {
-            while (av < 4) {
-                av = Serial.availableForWrite();
-            }
+    // Encodes frame into tx ring, never blocks. Frames that do not fit are dropped whole.
+    bool Write(const char* data, size_t size) noexcept {
+        size_t start = txHead;
+        bool ok = true;
+        for (size_t i = 0; ok && i < size; ++i) {
             char ch = data[i];
             switch (ch) {
             case END: {
-                Serial.write(ESC);
-                Serial.write(EscapedEnd);
+                ok = push(ESC) && push(EscapedEnd);
                 break;
             }
             case ESC: {
-                Serial.write(ESC);
-                Serial.write(EscapedEsc);
+                ok = push(ESC) && push(EscapedEsc);
                 break;
             }
             default: {
-                Serial.write(ch);
+                ok = push(ch);
                 break;
             }
             }
         }
-        Serial.write(END);
-        Serial.flush();
+        if (!ok || !push(END)) {
+            txHead = start;
+            overflows++;
+            return false;
+        }
+        size_t used = Pending();
+        if (used > peak) {
+            peak = used;
+        }
+        Poll();
+        return true;
+    }
+    // Moves as much of the ring as fits into Serial's interrupt-driven buffer
+    void Poll() noexcept {
+        size_t av = Serial.availableForWrite();
+        while (av && txTail != txHead) {
+            size_t chunk = (txHead > txTail ? txHead : TxBuff) - txTail;
+            if (chunk > av) {
+                chunk = av;
+            }
+            Serial.write(reinterpret_cast<const uint8_t*>(txBuff + txTail), chunk);
+            txTail = (txTail + chunk) % TxBuff;
+            av -= chunk;
+        }
+    }
+    size_t Pending() const noexcept {
+        return (txHead + TxBuff - txTail) % TxBuff;
+    }
+    uint16_t overflows = 0;
+    uint16_t peak = 0;
+private:
+    bool push(char ch) noexcept {
+        size_t next = (txHead + 1) % TxBuff;
+        if (next == txTail) {
+            return false;
+        }
+        txBuff[txHead] = ch;
+        txHead = next;
+        return true;
     }
+    char txBuff[TxBuff];
+    size_t txHead = 0;
+    size_t txTail = 0;
 };
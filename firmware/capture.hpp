@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stdint.h>
+#include "motor.hpp"
+#include "gen/MsgCaptureArm.h"
+#include "gen/MsgCaptureSample.h"
+
+#ifndef CAPTURE_SAMPLES
+#define CAPTURE_SAMPLES 128
+#endif
+
+// Step response recorder: armed from loop(), filled by the control tick,
+// then dumped from loop() at whatever rate the link allows.
+// The motor is stopped once the buffer is full. A MsgMove while recording
+// aborts the capture: samples so far are dumped, flagged aborted.
+struct Capture {
+    enum State : uint8_t {
+        Idle,
+        Recording,
+        Dumping,
+    };
+
+    // Call with interrupts disabled, arm.motor must be valid
+    void Arm(MsgCaptureArm const& arm, Motor& motor) noexcept {
+        conf = arm;
+        if (!conf.decimation) {
+            conf.decimation = 1;
+        }
+        if (!conf.samples || conf.samples > CAPTURE_SAMPLES) {
+            conf.samples = CAPTURE_SAMPLES;
+        }
+        count = 0;
+        sent = 0;
+        skip = 0;
+        aborted = false;
+        motor.SetTarget(Motor::FromMmPerSec(conf.speedMm));
+        state = Recording;
+    }
+
+    // Control tick
+    void Tick(Motor* motors) noexcept {
+        if (state != Recording || ++skip < conf.decimation) {
+            return;
+        }
+        skip = 0;
+        Motor& motor = motors[conf.motor];
+        record(motor);
+        if (count >= conf.samples) {
+            motor.SetTarget(0);
+            state = Dumping;
+        }
+    }
+
+    // Call with interrupts disabled, before the new target is set. The
+    // state at abort is recorded, so the host always gets a sample.
+    void Abort(Motor* motors) noexcept {
+        if (state != Recording) {
+            return;
+        }
+        record(motors[conf.motor]);
+        aborted = true;
+        state = Dumping;
+    }
+
+    // loop(): false once everything was sent
+    bool Next(MsgCaptureSample& out) noexcept {
+        if (state != Dumping) {
+            return false;
+        }
+        if (sent >= count) {
+            state = Idle;
+            return false;
+        }
+        Sample const& sample = buff[sent];
+        out.index = sent++;
+        out.count = count;
+        out.motor = conf.motor;
+        out.aborted = aborted;
+        out.targSpd = sample.targSpd;
+        out.currSpd = sample.currSpd;
+        out.pwm = sample.pwm;
+        out.dX = sample.dX;
+        return true;
+    }
+
+    volatile State state = Idle;
+private:
+    struct Sample {
+        int16_t targSpd;
+        int16_t currSpd;
+        int16_t pwm;
+        int16_t dX;
+    };
+    void record(Motor& motor) noexcept {
+        Sample& sample = buff[count++];
+        sample.targSpd = Motor::ToMmPerSec(motor.targSpd);
+        sample.currSpd = Motor::ToMmPerSec(motor.currSpd);
+        sample.pwm = motor.pwm;
+        sample.dX = motor.dX;
+    }
+
+    MsgCaptureArm conf = {};
+    Sample buff[CAPTURE_SAMPLES];
+    uint16_t count = 0;
+    uint16_t sent = 0;
+    uint8_t skip = 0;
+    bool aborted = false;
+};
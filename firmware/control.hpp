@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <Arduino.h>
+
+// Fixed-rate control tick from a hardware timer in CTC mode.
+// Timer5 is used where present (Mega), Timer1 otherwise: motor enable pins
+// must not be PWM pins of that timer (Mega: 44-46, Uno: 9-10).
+// The ISR is declared ISR_NOBLOCK, so encoder interrupts and micros() keep
+// working while a tick runs.
+
+#if defined(__AVR__)
+#include <avr/interrupt.h>
+
+#if defined(TIMSK5)
+#define CONTROL_TIMER_VECT TIMER5_COMPA_vect
+#define CONTROL_TCCRA TCCR5A
+#define CONTROL_TCCRB TCCR5B
+#define CONTROL_TCNT TCNT5
+#define CONTROL_OCRA OCR5A
+#define CONTROL_TIMSK TIMSK5
+#define CONTROL_WGM WGM52
+#define CONTROL_OCIE OCIE5A
+#else
+#define CONTROL_TIMER_VECT TIMER1_COMPA_vect
+#define CONTROL_TCCRA TCCR1A
+#define CONTROL_TCCRB TCCR1B
+#define CONTROL_TCNT TCNT1
+#define CONTROL_OCRA OCR1A
+#define CONTROL_TIMSK TIMSK1
+#define CONTROL_WGM WGM12
+#define CONTROL_OCIE OCIE1A
+#endif
+
+// Prescaler 64: 250kHz on 16MHz, valid for 4Hz..250kHz
+static inline void ControlTimerBegin(uint32_t hz) {
+  noInterrupts();
+  CONTROL_TCCRA = 0;
+  CONTROL_TCCRB = 0;
+  CONTROL_TCNT = 0;
+  CONTROL_OCRA = uint16_t(F_CPU / 64 / hz - 1);
+  CONTROL_TCCRB |= (1 << CONTROL_WGM) | (1 << CS11) | (1 << CS10);
+  CONTROL_TIMSK |= (1 << CONTROL_OCIE);
+  interrupts();
+}
+
+#define CONTROL_TICK(fn) ISR(CONTROL_TIMER_VECT, ISR_NOBLOCK) { fn(); }
+#define CONTROL_POLL()
+
+#else
+// No timer support: tick from loop() at the same nominal rate
+static uint32_t controlPeriodUs = 0;
+static void controlTick();
+
+static inline void ControlTimerBegin(uint32_t hz) {
+  controlPeriodUs = 1000000UL / hz;
+}
+
+#define CONTROL_TICK(fn) static void controlTick() { fn(); }
+#define CONTROL_POLL() do { \
+    static uint32_t last = micros(); \
+    if (micros() - last >= controlPeriodUs) { \
+      last += controlPeriodUs; \
+      controlTick(); \
+    } \
+  } while (0)
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include <Arduino.h>
+#if defined(__AVR__)
+#include <util/atomic.h>
+#endif
+
+// Edges counted per encoder period:
+// 1 - encoderA rising, 2 - encoderA both edges, 4 - both edges of A and B.
+// For 4x encoderB uses its external interrupt if it has one, its pin-change
+// interrupt otherwise (falls back to 2x if neither exists).
+#ifndef ENCODER_DECODING
+#define ENCODER_DECODING 4
+#endif
+
+#if ENCODER_DECODING != 1 && ENCODER_DECODING != 2 && ENCODER_DECODING != 4
+#error "ENCODER_DECODING must be 1, 2 or 4"
+#endif
+
+static volatile uint8_t fastPinNone = 0;
+
+// Input register and mask of a pin, read directly from ISRs
+struct FastPin {
+    volatile uint8_t* reg = &fastPinNone;
+    uint8_t mask = 0;
+
+    void Set(uint8_t pin) noexcept {
+        reg = portInputRegister(digitalPinToPort(pin));
+        mask = digitalPinToBitMask(pin);
+    }
+    bool Read() const noexcept {
+        return *reg & mask;
+    }
+};
+
+// Index: (previous AB << 2) | current AB, forward is 01 -> 11 -> 10 -> 00
+static constexpr int8_t QuadratureTable[16] = {
+    0, 1, -1, 0,
+    -1, 0, 0, 1,
+    1, 0, 0, -1,
+    0, -1, 1, 0,
+};
+
+// Atomic read of a counter updated from ISRs, safe inside ISR_NOBLOCK handlers too
+static inline uint32_t EncoderSnapshot(volatile uint32_t& counter) noexcept {
+    uint32_t res;
+#if defined(__AVR__)
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        res = counter;
+    }
+#else
+    noInterrupts();
+    res = counter;
+    interrupts();
+#endif
+    return res;
+}
+
+static inline void EncoderReset(volatile uint32_t& counter) noexcept {
+#if defined(__AVR__)
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        counter = 0;
+    }
+#else
+    noInterrupts();
+    counter = 0;
+    interrupts();
+#endif
+}
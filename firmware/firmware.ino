@@ -2,11 +2,19 @@
 #define MAX_SERVOS 15
 #define MOTORS_COUNT 3
 #define MSG_BUFFER 256
+#define CONTROL_HZ 200
+// Telemetry defaults, changed at runtime with MsgConfigTelemetry
 #define ODOM_DELAY_MS 30
+#define STATS_DELAY_MS 1000
 #define ECHO_MSGS 1
+// One bit per slot in MsgPinStates
+#define PIN_SLOTS 16
 
 #include <Arduino.h>
 #include "motor.hpp"
+#include "control.hpp"
+#include "pose.hpp"
+#include "capture.hpp"
 #include "Slip.hpp"
 #include "kadyrovlcd.h"
 #include "servo.hpp"
@@ -19,6 +27,15 @@
 #include "gen/MsgTest.h"
 #include "gen/MsgEcho.h"
 #include "gen/MsgReadPin.h"
+#include "gen/MsgOdomAll.h"
+#include "gen/MsgTxStats.h"
+#include "gen/MsgConfigPose.h"
+#include "gen/MsgPose.h"
+#include "gen/MsgConfigTelemetry.h"
+#include "gen/MsgCaptureArm.h"
+#include "gen/MsgCaptureSample.h"
+#include "gen/MsgSubscribePin.h"
+#include "gen/MsgPinStates.h"
 
 template<typename T>
 struct MsgTraits {
@@ -40,14 +57,24 @@ TRAITS_FOR(MsgConfigPinout)
 TRAITS_FOR(MsgTest)
 TRAITS_FOR(MsgEcho)
 TRAITS_FOR(MsgReadPin)
+TRAITS_FOR(MsgOdomAll)
+TRAITS_FOR(MsgTxStats)
+TRAITS_FOR(MsgConfigPose)
+TRAITS_FOR(MsgPose)
+TRAITS_FOR(MsgConfigTelemetry)
+TRAITS_FOR(MsgCaptureArm)
+TRAITS_FOR(MsgCaptureSample)
+TRAITS_FOR(MsgSubscribePin)
+TRAITS_FOR(MsgPinStates)
 
+// Subscribed pins, debounced once per millisecond: a state must hold for
+// neededCount consecutive reads before it is reported
 struct PinState {
-  explicit PinState(int pin, int neededCount) : pin(pin), neededCount(neededCount) {}
   bool measure{ false };
   bool current{ false };
   int neededCount{};
   int currentCount{ 0 };
-  int pin{};
+  int pin{ -1 };
 };
 
 bool debounce(PinState& state) {
@@ -65,16 +92,38 @@ bool debounce(PinState& state) {
 }
 
 static KadyrovLcd lcd(KadyrovLcd::Address::OLD);
+static Motor motors[MOTORS_COUNT] = {};
+
+enum Streams : uint8_t {
+  StreamOdom = 1,
+  StreamPose = 2,
+  StreamStats = 4,
+};
+
+static MsgConfigTelemetry telemetry = {
+  ODOM_DELAY_MS, STATS_DELAY_MS, ECHO_MSGS,
+  StreamOdom | StreamPose | StreamStats
+};
 
 struct RawMsg;
 static void Update();
+static void SendPose();
+static void SendCapture();
+static void WatchPins();
+static void Stats();
 static void Handle(RawMsg& msg);
+static void Announce();
 
 void setup() {
   pinMode(LED_BUILTIN, OUTPUT);
   digitalWrite(LED_BUILTIN, 0);
   lcd.setup();
   Serial.begin(BAUD_RATE);
+  for (auto& motor: motors) {
+    motor.SetPeriod(1000000UL / CONTROL_HZ);
+  }
+  ControlTimerBegin(CONTROL_HZ);
+  Announce();
 }
 
 struct Throttle {
@@ -99,51 +148,110 @@ struct RawMsg {
   size_t size;
 };
 
+enum Flags {
+  Request = 1,
+  Ack = Request,
+  // Legacy-header negotiation of compact headers (see FrameHeader)
+  Compact = 2,
+  // Back to legacy headers, from either mode
+  Reset = 4,
+};
+
+// Host asks with Request|Compact, we ack with Ack|Compact and switch tx.
+// Host then commits with Compact, after which its frames are compact too.
+// On boot we announce with a legacy Compact frame, so a host left in compact
+// mode by our reset negotiates again. A host (re)connecting sends a legacy
+// Reset frame, taken in both modes: read as compact it is type 0 without
+// Request, which compact hosts never send.
+static bool compactRx = false;
+static bool compactTx = false;
+
+static void SendAck(uint32_t id, uint16_t flags = Ack);
+
+static bool isReset(const char* begin, size_t size) {
+  char reset[FrameHeader::MaxSize];
+  FrameHeader header = {0, 0, Reset};
+  size_t rsize = header.Dump(false, reset);
+  return size == rsize && !memcmp(begin, reset, rsize);
+}
+
 static void handleFrame(char* begin, size_t size) {
-  if (size < 8) {
+  if (isReset(begin, size)) {
+    compactRx = false;
+    compactTx = false;
+    return;
+  }
+  FrameHeader header;
+  size_t hsize = header.Parse(compactRx, begin, size);
+  if (!hsize) {
+    return;
+  }
+  if (!compactRx && header.type == 0 && (header.flags & Compact)) {
+    if (header.flags & Request) {
+      compactTx = false;
+      SendAck(header.id, Ack | Compact);
+      compactTx = true;
+    } else {
+      compactRx = true;
+    }
     return;
   }
   RawMsg msg;
-  memcpy(&msg.id, begin, 4);
-  memcpy(&msg.type, begin + 4, 2);
-  memcpy(&msg.flags, begin + 6, 2);
-  msg.body = begin + 8;
-  msg.size = size - 8;
+  msg.id = header.id;
+  msg.type = header.type;
+  msg.flags = header.flags;
+  msg.body = begin + hsize;
+  msg.size = size - hsize;
   Handle(msg);
 }
 
 static Slip<handleFrame> slip;
 
 void loop() {
+  CONTROL_POLL();
   Update();
+  SendPose();
+  SendCapture();
+  WatchPins();
+  Stats();
   slip.Read();
+  slip.Poll();
 }
 
-enum Flags {
-  Request = 1,
-  Ack = Request,
-};
-
+static void SendAck(uint32_t id, uint16_t flags) {
+  char buff[FrameHeader::MaxSize];
+  FrameHeader header = {id, 0, flags};
+  slip.Write(buff, header.Dump(compactTx, buff));
+}
 
-static void SendAck(uint32_t id) {
-  char buff[8];
-  uint16_t flags = Ack;
-  memcpy(buff, &id, 4);
-  memset(buff + 4, 0, 2);
-  memcpy(buff + 6, &flags, 2);
-  slip.Write(buff, sizeof(buff));
+static void Announce() {
+  SendAck(0, Compact);
 }
 
-static Motor motors[MOTORS_COUNT] = {};
 
+// One instance per motor, so the ISR addresses its motor statically
 template<size_t I>
 void MotorCb() {
-  if (digitalRead(motors[I].GetPinout().encoderB) == HIGH) {
-    motors[I].X++;
-  } else {
-    motors[I].X--;
-  }
+  motors[I].EncoderEdge();
+}
+
+#if ENCODER_DECODING == 4 && defined(PCICR)
+// encoderB pins without external interrupts; unchanged motors count 0
+static void PinChange() {
+  MotorCb<0>();
+  MotorCb<1>();
+  MotorCb<2>();
 }
+#ifdef PCINT0_vect
+ISR(PCINT0_vect) { PinChange(); }
+#endif
+#ifdef PCINT1_vect
+ISR(PCINT1_vect) { PinChange(); }
+#endif
+#ifdef PCINT2_vect
+ISR(PCINT2_vect) { PinChange(); }
+#endif
+#endif
 
 template<typename T, typename U>
 static bool Deserialize(T& res, const U& msg) {
@@ -152,39 +260,164 @@ static bool Deserialize(T& res, const U& msg) {
 
 template<typename T>
 static void Send(const T& msg) {
-  char buff[sizeof(T) + 8] = {};
-  memcpy(buff + 4, &MsgTraits<T>::Type, 2);
-  MsgTraits<T>::writer(&msg, buff + 8, sizeof(buff) - 8);
-  slip.Write(buff, sizeof(buff));
+  char buff[sizeof(T) + FrameHeader::MaxSize];
+  FrameHeader header = {0, MsgTraits<T>::Type, 0};
+  size_t hsize = header.Dump(compactTx, buff);
+  size_t size = MsgTraits<T>::writer(&msg, buff + hsize, sizeof(T));
+  slip.Write(buff, hsize + size);
+}
+
+static_assert(MOTORS_COUNT == 3, "MsgOdomAll carries exactly 3 motors");
+
+// Written from the control tick, read with interrupts disabled
+static Motor::Dist odom[MOTORS_COUNT] = {};
+static volatile bool ticking = false;
+static PoseIntegrator pose;
+static Capture capture;
+
+// Encoder sampling, PID and PWM for all motors at CONTROL_HZ
+static void ControlTick() {
+  // Previous tick still running: skip rather than nest
+  if (ticking) {
+    return;
+  }
+  ticking = true;
+  Motor::Dist ddists[MOTORS_COUNT];
+  for (auto i = 0; i < MOTORS_COUNT; ++i) {
+    ddists[i] = motors[i].Update();
+    odom[i] += ddists[i];
+  }
+  pose.Step(ddists, motors, MOTORS_COUNT);
+  capture.Tick(motors);
+  ticking = false;
 }
 
+CONTROL_TICK(ControlTick)
+
 static void Update() {
   static Throttle limit(ODOM_DELAY_MS);
-  bool send = limit();
+  static uint16_t seq = 0;
+  limit.each = telemetry.odomPeriodMs;
+  if (!limit()) {
+    return;
+  }
+  if (!(telemetry.streams & StreamOdom)) {
+    // Drop what was travelled, so the accumulators cannot overflow
+    noInterrupts();
+    for (auto& acc: odom) {
+      acc = 0;
+    }
+    interrupts();
+    return;
+  }
+  MsgOdomAll msg = {};
+  msg.micros = micros();
+  msg.seq = seq++;
+  int16_t* ddists[MOTORS_COUNT] = {&msg.ddist0_mm, &msg.ddist1_mm, &msg.ddist2_mm};
+  noInterrupts();
   for (auto i = 0; i < MOTORS_COUNT; ++i) {
-    auto ddist = motors[i].Update();
-    if (send) {
-        MsgOdom msg = {};
-        msg.num = i;
-        msg.ddist_mm = ddist * 1000.f;
-        Send(msg);
+    // Keep sub-millimeter remainder for the next message
+    *ddists[i] = Motor::TakeMillimeters(odom[i]);
+  }
+  interrupts();
+  Send(msg);
+}
+
+static void SendPose() {
+  static Throttle limit(0);
+  static uint16_t seq = 0;
+  noInterrupts();
+  limit.each = pose.conf.periodMs;
+  bool enabled = pose.conf.enable && (telemetry.streams & StreamPose);
+  interrupts();
+  if (!enabled || !limit()) {
+    return;
+  }
+  noInterrupts();
+  PoseIntegrator current = pose;
+  interrupts();
+  MsgPose msg = {};
+  msg.micros = micros();
+  msg.seq = seq++;
+  current.Fill(msg);
+  Send(msg);
+}
+
+static void SendCapture() {
+  MsgCaptureSample sample;
+  // Leave room in the tx ring for other streams
+  while (slip.Pending() < 64 && capture.Next(sample)) {
+    Send(sample);
+  }
+}
+
+static_assert(PIN_SLOTS <= 16, "MsgPinStates carries 16 slots");
+
+static PinState pins[PIN_SLOTS];
+static uint16_t pinStates = 0;
+// Slots (re)subscribed since the last push, reported even if unchanged
+static uint16_t pinFresh = 0;
+
+// Pushes MsgPinStates only when a debounced state changes
+static void WatchPins() {
+  static Throttle limit(0);
+  if (!limit()) {
+    return;
+  }
+  uint16_t states = 0;
+  for (auto i = 0; i < PIN_SLOTS; ++i) {
+    if (pins[i].pin >= 0 && debounce(pins[i])) {
+      states |= uint16_t(1) << i;
     }
   }
+  uint16_t changed = (states ^ pinStates) | pinFresh;
+  if (!changed) {
+    return;
+  }
+  pinStates = states;
+  pinFresh = 0;
+  MsgPinStates msg;
+  msg.micros = micros();
+  msg.states = states;
+  msg.changed = changed;
+  Send(msg);
+}
+
+static void Stats() {
+  static Throttle limit(STATS_DELAY_MS);
+  limit.each = telemetry.statsPeriodMs;
+  if (!(telemetry.streams & StreamStats) || !limit()) {
+    return;
+  }
+  MsgTxStats stats = {};
+  stats.overflows = slip.overflows;
+  stats.peak = slip.peak;
+  Send(stats);
 }
 
 static void Handle(RawMsg& msg) {
-#if ECHO_MSGS
-  MsgEcho echo = {};
-  echo.type = msg.type;
-  echo.size = msg.size;
-  Send(echo);
-#endif
+  if (telemetry.echo) {
+    MsgEcho echo = {};
+    echo.type = msg.type;
+    echo.size = msg.size;
+    Send(echo);
+  }
+  if (msg.flags & Request) {
+    SendAck(msg.id);
+  }
   switch (msg.type) {
   case MsgPid_Type: {
     MsgPid pid;
     if (!Deserialize(pid, msg)) {
       return;
     }
+    if (pid.motor < 0 || pid.motor >= MOTORS_COUNT) {
+      return;
+    }
+    // Gains are sent in thousandths
+    noInterrupts();
+    motors[pid.motor].SetGains(pid.p / 1000.f, pid.i / 1000.f, pid.d / 1000.f);
+    interrupts();
     break;
   }
   case MsgMove_Type: {
@@ -192,12 +425,12 @@ static void Handle(RawMsg& msg) {
     if (!Deserialize(move, msg)) {
       return;
     }
-    float x = move.x/1000.f;
-    float y = move.y/1000.f;
-    float z = move.theta/1000.f;
+    noInterrupts();
+    capture.Abort(motors);
     for (auto i = 0; i < MOTORS_COUNT; ++i) {
-        motors[i].SpeedCallback(x, y, z);
+        motors[i].SpeedCallback(move.x, move.y, move.theta);
     }
+    interrupts();
     break;
   }
   case MsgConfigMotor_Type: {
@@ -208,7 +441,9 @@ static void Handle(RawMsg& msg) {
     if (conf.num >= MOTORS_COUNT) {
         return;
     }
+    noInterrupts();
     motors[conf.num].SetParams(conf);
+    interrupts();
     break;
   }
   case MsgReadPin_Type: {
@@ -221,6 +456,28 @@ static void Handle(RawMsg& msg) {
     Send(pin); 
     break;
   }
+  case MsgSubscribePin_Type: {
+    MsgSubscribePin sub;
+    if (!Deserialize(sub, msg)) {
+      return;
+    }
+    if (sub.slot >= PIN_SLOTS) {
+      return;
+    }
+    auto& state = pins[sub.slot];
+    // Negative pin frees the slot
+    state.pin = sub.pin;
+    state.neededCount = sub.debounceMs;
+    state.currentCount = 0;
+    if (sub.pin >= 0) {
+      pinMode(sub.pin, sub.pullup ? INPUT_PULLUP : INPUT);
+      state.current = digitalRead(sub.pin);
+    } else {
+      state.current = false;
+    }
+    pinFresh |= uint16_t(1) << sub.slot;
+    break;
+  }
   case MsgConfigPinout_Type: {
     MsgConfigPinout conf;
     if (!Deserialize(conf, msg)) {
@@ -236,7 +493,40 @@ static void Handle(RawMsg& msg) {
     case 2: cb = MotorCb<2>; break;
     default: return;
     }
+    noInterrupts();
     motors[conf.num].SetPinout(cb, conf);
+    interrupts();
+    break;
+  }
+  case MsgConfigPose_Type: {
+    MsgConfigPose conf;
+    if (!Deserialize(conf, msg)) {
+      return;
+    }
+    noInterrupts();
+    pose.Configure(conf);
+    interrupts();
+    break;
+  }
+  case MsgConfigTelemetry_Type: {
+    MsgConfigTelemetry conf;
+    if (!Deserialize(conf, msg)) {
+      return;
+    }
+    telemetry = conf;
+    break;
+  }
+  case MsgCaptureArm_Type: {
+    MsgCaptureArm arm;
+    if (!Deserialize(arm, msg)) {
+      return;
+    }
+    if (arm.motor >= MOTORS_COUNT || capture.state == Capture::Recording) {
+      return;
+    }
+    noInterrupts();
+    capture.Arm(arm, motors[arm.motor]);
+    interrupts();
     break;
   }
   case MsgTest_Type: {
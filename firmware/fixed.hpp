@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdint.h>
+
+// Q16.16 fixed point: 1.0 == 65536, range +-32767
+typedef int32_t q16_t;
+
+#define Q16_ONE 65536L
+
+static inline q16_t q16FromFloat(float f)
+{
+    return q16_t(f * float(Q16_ONE) + (f >= 0 ? 0.5f : -0.5f));
+}
+
+static inline float q16ToFloat(q16_t q)
+{
+    return q / float(Q16_ONE);
+}
+
+static inline q16_t q16Mul(q16_t a, q16_t b)
+{
+    return q16_t((int64_t(a) * b) >> 16);
+}
+
+// Integer part, rounded towards zero
+static inline int16_t q16Trunc(q16_t q)
+{
+    return int16_t(q >= 0 ? q >> 16 : -((-q) >> 16));
+}
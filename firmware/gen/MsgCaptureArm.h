@@ -0,0 +1,69 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef float float32_t;
+typedef double float64_t;
+
+#ifndef MSG_LITTLE_ENDIAN
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MSG_LITTLE_ENDIAN 1
+#else
+#define MSG_LITTLE_ENDIAN 0
+#endif
+#endif
+
+typedef enum {
+    MsgCaptureArm_Type = 16,
+} MsgCaptureArm_;
+
+struct MsgCaptureArm {
+    uint8_t motor;
+    uint8_t decimation;
+    int16_t speedMm;
+    uint16_t samples;
+};
+
+// Naturally packed: wire layout is the in-memory layout
+#if MSG_LITTLE_ENDIAN
+static_assert(sizeof(MsgCaptureArm) == 6, "MsgCaptureArm: unexpected padding");
+static_assert(offsetof(MsgCaptureArm, motor) == 0, "MsgCaptureArm: unexpected offset of motor");
+static_assert(offsetof(MsgCaptureArm, decimation) == 1, "MsgCaptureArm: unexpected offset of decimation");
+static_assert(offsetof(MsgCaptureArm, speedMm) == 2, "MsgCaptureArm: unexpected offset of speedMm");
+static_assert(offsetof(MsgCaptureArm, samples) == 4, "MsgCaptureArm: unexpected offset of samples");
+#endif
+
+static inline size_t parse_MsgCaptureArm(MsgCaptureArm* __restrict__ out, const char* __restrict__ src, size_t size) {
+    if (size < 6) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(out, src, 6);
+#else
+    memcpy(&out->motor, src, sizeof(out->motor));
+    src += sizeof(out->motor);
+    memcpy(&out->decimation, src, sizeof(out->decimation));
+    src += sizeof(out->decimation);
+    memcpy(&out->speedMm, src, sizeof(out->speedMm));
+    src += sizeof(out->speedMm);
+    memcpy(&out->samples, src, sizeof(out->samples));
+    src += sizeof(out->samples);
+#endif
+    return 6;
+}
+
+static inline size_t dump_MsgCaptureArm(const MsgCaptureArm* __restrict__ obj, char* __restrict__ buff, size_t size) {
+    if (size < 6) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(buff, obj, 6);
+#else
+    memcpy(buff, &obj->motor, sizeof(obj->motor));
+    buff += sizeof(obj->motor);
+    memcpy(buff, &obj->decimation, sizeof(obj->decimation));
+    buff += sizeof(obj->decimation);
+    memcpy(buff, &obj->speedMm, sizeof(obj->speedMm));
+    buff += sizeof(obj->speedMm);
+    memcpy(buff, &obj->samples, sizeof(obj->samples));
+    buff += sizeof(obj->samples);
+#endif
+    return 6;
+}
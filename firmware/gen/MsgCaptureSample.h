@@ -0,0 +1,93 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef float float32_t;
+typedef double float64_t;
+
+#ifndef MSG_LITTLE_ENDIAN
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MSG_LITTLE_ENDIAN 1
+#else
+#define MSG_LITTLE_ENDIAN 0
+#endif
+#endif
+
+typedef enum {
+    MsgCaptureSample_Type = 17,
+} MsgCaptureSample_;
+
+struct MsgCaptureSample {
+    uint16_t index;
+    uint16_t count;
+    uint8_t motor;
+    uint8_t aborted;
+    int16_t targSpd;
+    int16_t currSpd;
+    int16_t pwm;
+    int16_t dX;
+};
+
+// Naturally packed: wire layout is the in-memory layout
+#if MSG_LITTLE_ENDIAN
+static_assert(sizeof(MsgCaptureSample) == 14, "MsgCaptureSample: unexpected padding");
+static_assert(offsetof(MsgCaptureSample, index) == 0, "MsgCaptureSample: unexpected offset of index");
+static_assert(offsetof(MsgCaptureSample, count) == 2, "MsgCaptureSample: unexpected offset of count");
+static_assert(offsetof(MsgCaptureSample, motor) == 4, "MsgCaptureSample: unexpected offset of motor");
+static_assert(offsetof(MsgCaptureSample, aborted) == 5, "MsgCaptureSample: unexpected offset of aborted");
+static_assert(offsetof(MsgCaptureSample, targSpd) == 6, "MsgCaptureSample: unexpected offset of targSpd");
+static_assert(offsetof(MsgCaptureSample, currSpd) == 8, "MsgCaptureSample: unexpected offset of currSpd");
+static_assert(offsetof(MsgCaptureSample, pwm) == 10, "MsgCaptureSample: unexpected offset of pwm");
+static_assert(offsetof(MsgCaptureSample, dX) == 12, "MsgCaptureSample: unexpected offset of dX");
+#endif
+
+static inline size_t parse_MsgCaptureSample(MsgCaptureSample* __restrict__ out, const char* __restrict__ src, size_t size) {
+    if (size < 14) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(out, src, 14);
+#else
+    memcpy(&out->index, src, sizeof(out->index));
+    src += sizeof(out->index);
+    memcpy(&out->count, src, sizeof(out->count));
+    src += sizeof(out->count);
+    memcpy(&out->motor, src, sizeof(out->motor));
+    src += sizeof(out->motor);
+    memcpy(&out->aborted, src, sizeof(out->aborted));
+    src += sizeof(out->aborted);
+    memcpy(&out->targSpd, src, sizeof(out->targSpd));
+    src += sizeof(out->targSpd);
+    memcpy(&out->currSpd, src, sizeof(out->currSpd));
+    src += sizeof(out->currSpd);
+    memcpy(&out->pwm, src, sizeof(out->pwm));
+    src += sizeof(out->pwm);
+    memcpy(&out->dX, src, sizeof(out->dX));
+    src += sizeof(out->dX);
+#endif
+    return 14;
+}
+
+static inline size_t dump_MsgCaptureSample(const MsgCaptureSample* __restrict__ obj, char* __restrict__ buff, size_t size) {
+    if (size < 14) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(buff, obj, 14);
+#else
+    memcpy(buff, &obj->index, sizeof(obj->index));
+    buff += sizeof(obj->index);
+    memcpy(buff, &obj->count, sizeof(obj->count));
+    buff += sizeof(obj->count);
+    memcpy(buff, &obj->motor, sizeof(obj->motor));
+    buff += sizeof(obj->motor);
+    memcpy(buff, &obj->aborted, sizeof(obj->aborted));
+    buff += sizeof(obj->aborted);
+    memcpy(buff, &obj->targSpd, sizeof(obj->targSpd));
+    buff += sizeof(obj->targSpd);
+    memcpy(buff, &obj->currSpd, sizeof(obj->currSpd));
+    buff += sizeof(obj->currSpd);
+    memcpy(buff, &obj->pwm, sizeof(obj->pwm));
+    buff += sizeof(obj->pwm);
+    memcpy(buff, &obj->dX, sizeof(obj->dX));
+    buff += sizeof(obj->dX);
+#endif
+    return 14;
+}
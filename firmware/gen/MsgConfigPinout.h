@@ -6,6 +6,14 @@
 typedef float float32_t;
 typedef double float64_t;
 
+#ifndef MSG_LITTLE_ENDIAN
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MSG_LITTLE_ENDIAN 1
+#else
+#define MSG_LITTLE_ENDIAN 0
+#endif
+#endif
+
 typedef enum {
     MsgConfigPinout_Type = 8,
 } MsgConfigPinout_;
@@ -19,8 +27,22 @@ struct MsgConfigPinout {
     int8_t back;
 };
 
+// Naturally packed: wire layout is the in-memory layout
+#if MSG_LITTLE_ENDIAN
+static_assert(sizeof(MsgConfigPinout) == 6, "MsgConfigPinout: unexpected padding");
+static_assert(offsetof(MsgConfigPinout, num) == 0, "MsgConfigPinout: unexpected offset of num");
+static_assert(offsetof(MsgConfigPinout, encoderA) == 1, "MsgConfigPinout: unexpected offset of encoderA");
+static_assert(offsetof(MsgConfigPinout, encoderB) == 2, "MsgConfigPinout: unexpected offset of encoderB");
+static_assert(offsetof(MsgConfigPinout, enable) == 3, "MsgConfigPinout: unexpected offset of enable");
+static_assert(offsetof(MsgConfigPinout, fwd) == 4, "MsgConfigPinout: unexpected offset of fwd");
+static_assert(offsetof(MsgConfigPinout, back) == 5, "MsgConfigPinout: unexpected offset of back");
+#endif
+
 static inline size_t parse_MsgConfigPinout(MsgConfigPinout* __restrict__ out, const char* __restrict__ src, size_t size) {
     if (size < 6) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(out, src, 6);
+#else
     memcpy(&out->num, src, sizeof(out->num));
     src += sizeof(out->num);
     memcpy(&out->encoderA, src, sizeof(out->encoderA));
@@ -33,11 +55,15 @@ static inline size_t parse_MsgConfigPinout(MsgConfigPinout* __restrict__ out, co
     src += sizeof(out->fwd);
     memcpy(&out->back, src, sizeof(out->back));
     src += sizeof(out->back);
+#endif
     return 6;
 }
 
 static inline size_t dump_MsgConfigPinout(const MsgConfigPinout* __restrict__ obj, char* __restrict__ buff, size_t size) {
     if (size < 6) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(buff, obj, 6);
+#else
     memcpy(buff, &obj->num, sizeof(obj->num));
     buff += sizeof(obj->num);
     memcpy(buff, &obj->encoderA, sizeof(obj->encoderA));
@@ -50,5 +76,6 @@ static inline size_t dump_MsgConfigPinout(const MsgConfigPinout* __restrict__ ob
     buff += sizeof(obj->fwd);
     memcpy(buff, &obj->back, sizeof(obj->back));
     buff += sizeof(obj->back);
+#endif
     return 6;
 }
@@ -0,0 +1,87 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef float float32_t;
+typedef double float64_t;
+
+#ifndef MSG_LITTLE_ENDIAN
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MSG_LITTLE_ENDIAN 1
+#else
+#define MSG_LITTLE_ENDIAN 0
+#endif
+#endif
+
+typedef enum {
+    MsgConfigPose_Type = 13,
+} MsgConfigPose_;
+
+struct MsgConfigPose {
+    uint8_t enable;
+    uint8_t reset;
+    uint16_t periodMs;
+    float32_t baseRadius;
+    float32_t thetaCoeff;
+    float32_t xCoeff;
+    float32_t yCoeff;
+};
+
+// Naturally packed: wire layout is the in-memory layout
+#if MSG_LITTLE_ENDIAN
+static_assert(sizeof(MsgConfigPose) == 20, "MsgConfigPose: unexpected padding");
+static_assert(offsetof(MsgConfigPose, enable) == 0, "MsgConfigPose: unexpected offset of enable");
+static_assert(offsetof(MsgConfigPose, reset) == 1, "MsgConfigPose: unexpected offset of reset");
+static_assert(offsetof(MsgConfigPose, periodMs) == 2, "MsgConfigPose: unexpected offset of periodMs");
+static_assert(offsetof(MsgConfigPose, baseRadius) == 4, "MsgConfigPose: unexpected offset of baseRadius");
+static_assert(offsetof(MsgConfigPose, thetaCoeff) == 8, "MsgConfigPose: unexpected offset of thetaCoeff");
+static_assert(offsetof(MsgConfigPose, xCoeff) == 12, "MsgConfigPose: unexpected offset of xCoeff");
+static_assert(offsetof(MsgConfigPose, yCoeff) == 16, "MsgConfigPose: unexpected offset of yCoeff");
+#endif
+
+static inline size_t parse_MsgConfigPose(MsgConfigPose* __restrict__ out, const char* __restrict__ src, size_t size) {
+    if (size < 20) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(out, src, 20);
+#else
+    memcpy(&out->enable, src, sizeof(out->enable));
+    src += sizeof(out->enable);
+    memcpy(&out->reset, src, sizeof(out->reset));
+    src += sizeof(out->reset);
+    memcpy(&out->periodMs, src, sizeof(out->periodMs));
+    src += sizeof(out->periodMs);
+    memcpy(&out->baseRadius, src, sizeof(out->baseRadius));
+    src += sizeof(out->baseRadius);
+    memcpy(&out->thetaCoeff, src, sizeof(out->thetaCoeff));
+    src += sizeof(out->thetaCoeff);
+    memcpy(&out->xCoeff, src, sizeof(out->xCoeff));
+    src += sizeof(out->xCoeff);
+    memcpy(&out->yCoeff, src, sizeof(out->yCoeff));
+    src += sizeof(out->yCoeff);
+#endif
+    return 20;
+}
+
+static inline size_t dump_MsgConfigPose(const MsgConfigPose* __restrict__ obj, char* __restrict__ buff, size_t size) {
+    if (size < 20) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(buff, obj, 20);
+#else
+    memcpy(buff, &obj->enable, sizeof(obj->enable));
+    buff += sizeof(obj->enable);
+    memcpy(buff, &obj->reset, sizeof(obj->reset));
+    buff += sizeof(obj->reset);
+    memcpy(buff, &obj->periodMs, sizeof(obj->periodMs));
+    buff += sizeof(obj->periodMs);
+    memcpy(buff, &obj->baseRadius, sizeof(obj->baseRadius));
+    buff += sizeof(obj->baseRadius);
+    memcpy(buff, &obj->thetaCoeff, sizeof(obj->thetaCoeff));
+    buff += sizeof(obj->thetaCoeff);
+    memcpy(buff, &obj->xCoeff, sizeof(obj->xCoeff));
+    buff += sizeof(obj->xCoeff);
+    memcpy(buff, &obj->yCoeff, sizeof(obj->yCoeff));
+    buff += sizeof(obj->yCoeff);
+#endif
+    return 20;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef float float32_t;
+typedef double float64_t;
+
+#ifndef MSG_LITTLE_ENDIAN
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MSG_LITTLE_ENDIAN 1
+#else
+#define MSG_LITTLE_ENDIAN 0
+#endif
+#endif
+
+typedef enum {
+    MsgConfigTelemetry_Type = 15,
+} MsgConfigTelemetry_;
+
+struct MsgConfigTelemetry {
+    uint16_t odomPeriodMs;
+    uint16_t statsPeriodMs;
+    uint8_t echo;
+    uint8_t streams;
+};
+
+// Naturally packed: wire layout is the in-memory layout
+#if MSG_LITTLE_ENDIAN
+static_assert(sizeof(MsgConfigTelemetry) == 6, "MsgConfigTelemetry: unexpected padding");
+static_assert(offsetof(MsgConfigTelemetry, odomPeriodMs) == 0, "MsgConfigTelemetry: unexpected offset of odomPeriodMs");
+static_assert(offsetof(MsgConfigTelemetry, statsPeriodMs) == 2, "MsgConfigTelemetry: unexpected offset of statsPeriodMs");
+static_assert(offsetof(MsgConfigTelemetry, echo) == 4, "MsgConfigTelemetry: unexpected offset of echo");
+static_assert(offsetof(MsgConfigTelemetry, streams) == 5, "MsgConfigTelemetry: unexpected offset of streams");
+#endif
+
+static inline size_t parse_MsgConfigTelemetry(MsgConfigTelemetry* __restrict__ out, const char* __restrict__ src, size_t size) {
+    if (size < 6) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(out, src, 6);
+#else
+    memcpy(&out->odomPeriodMs, src, sizeof(out->odomPeriodMs));
+    src += sizeof(out->odomPeriodMs);
+    memcpy(&out->statsPeriodMs, src, sizeof(out->statsPeriodMs));
+    src += sizeof(out->statsPeriodMs);
+    memcpy(&out->echo, src, sizeof(out->echo));
+    src += sizeof(out->echo);
+    memcpy(&out->streams, src, sizeof(out->streams));
+    src += sizeof(out->streams);
+#endif
+    return 6;
+}
+
+static inline size_t dump_MsgConfigTelemetry(const MsgConfigTelemetry* __restrict__ obj, char* __restrict__ buff, size_t size) {
+    if (size < 6) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(buff, obj, 6);
+#else
+    memcpy(buff, &obj->odomPeriodMs, sizeof(obj->odomPeriodMs));
+    buff += sizeof(obj->odomPeriodMs);
+    memcpy(buff, &obj->statsPeriodMs, sizeof(obj->statsPeriodMs));
+    buff += sizeof(obj->statsPeriodMs);
+    memcpy(buff, &obj->echo, sizeof(obj->echo));
+    buff += sizeof(obj->echo);
+    memcpy(buff, &obj->streams, sizeof(obj->streams));
+    buff += sizeof(obj->streams);
+#endif
+    return 6;
+}
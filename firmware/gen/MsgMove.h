@@ -6,6 +6,14 @@
 typedef float float32_t;
 typedef double float64_t;
 
+#ifndef MSG_LITTLE_ENDIAN
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MSG_LITTLE_ENDIAN 1
+#else
+#define MSG_LITTLE_ENDIAN 0
+#endif
+#endif
+
 typedef enum {
     MsgMove_Type = 1,
 } MsgMove_;
@@ -16,24 +24,40 @@ struct MsgMove {
     int16_t theta;
 };
 
+// Naturally packed: wire layout is the in-memory layout
+#if MSG_LITTLE_ENDIAN
+static_assert(sizeof(MsgMove) == 6, "MsgMove: unexpected padding");
+static_assert(offsetof(MsgMove, x) == 0, "MsgMove: unexpected offset of x");
+static_assert(offsetof(MsgMove, y) == 2, "MsgMove: unexpected offset of y");
+static_assert(offsetof(MsgMove, theta) == 4, "MsgMove: unexpected offset of theta");
+#endif
+
 static inline size_t parse_MsgMove(MsgMove* __restrict__ out, const char* __restrict__ src, size_t size) {
     if (size < 6) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(out, src, 6);
+#else
     memcpy(&out->x, src, sizeof(out->x));
     src += sizeof(out->x);
     memcpy(&out->y, src, sizeof(out->y));
     src += sizeof(out->y);
     memcpy(&out->theta, src, sizeof(out->theta));
     src += sizeof(out->theta);
+#endif
     return 6;
 }
 
 static inline size_t dump_MsgMove(const MsgMove* __restrict__ obj, char* __restrict__ buff, size_t size) {
     if (size < 6) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(buff, obj, 6);
+#else
     memcpy(buff, &obj->x, sizeof(obj->x));
     buff += sizeof(obj->x);
     memcpy(buff, &obj->y, sizeof(obj->y));
     buff += sizeof(obj->y);
     memcpy(buff, &obj->theta, sizeof(obj->theta));
     buff += sizeof(obj->theta);
+#endif
     return 6;
 }
@@ -6,6 +6,14 @@
 typedef float float32_t;
 typedef double float64_t;
 
+#ifndef MSG_LITTLE_ENDIAN
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MSG_LITTLE_ENDIAN 1
+#else
+#define MSG_LITTLE_ENDIAN 0
+#endif
+#endif
+
 typedef enum {
     MsgOdom_Type = 2,
 } MsgOdom_;
@@ -16,24 +24,40 @@ struct MsgOdom {
     int16_t ddist_mm;
 };
 
+// Naturally packed: wire layout is the in-memory layout
+#if MSG_LITTLE_ENDIAN
+static_assert(sizeof(MsgOdom) == 4, "MsgOdom: unexpected padding");
+static_assert(offsetof(MsgOdom, num) == 0, "MsgOdom: unexpected offset of num");
+static_assert(offsetof(MsgOdom, aux) == 1, "MsgOdom: unexpected offset of aux");
+static_assert(offsetof(MsgOdom, ddist_mm) == 2, "MsgOdom: unexpected offset of ddist_mm");
+#endif
+
 static inline size_t parse_MsgOdom(MsgOdom* __restrict__ out, const char* __restrict__ src, size_t size) {
     if (size < 4) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(out, src, 4);
+#else
     memcpy(&out->num, src, sizeof(out->num));
     src += sizeof(out->num);
     memcpy(&out->aux, src, sizeof(out->aux));
     src += sizeof(out->aux);
     memcpy(&out->ddist_mm, src, sizeof(out->ddist_mm));
     src += sizeof(out->ddist_mm);
+#endif
     return 4;
 }
 
 static inline size_t dump_MsgOdom(const MsgOdom* __restrict__ obj, char* __restrict__ buff, size_t size) {
     if (size < 4) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(buff, obj, 4);
+#else
     memcpy(buff, &obj->num, sizeof(obj->num));
     buff += sizeof(obj->num);
     memcpy(buff, &obj->aux, sizeof(obj->aux));
     buff += sizeof(obj->aux);
     memcpy(buff, &obj->ddist_mm, sizeof(obj->ddist_mm));
     buff += sizeof(obj->ddist_mm);
+#endif
     return 4;
 }
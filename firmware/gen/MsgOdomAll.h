@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef float float32_t;
+typedef double float64_t;
+
+#ifndef MSG_LITTLE_ENDIAN
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MSG_LITTLE_ENDIAN 1
+#else
+#define MSG_LITTLE_ENDIAN 0
+#endif
+#endif
+
+typedef enum {
+    MsgOdomAll_Type = 10,
+} MsgOdomAll_;
+
+struct MsgOdomAll {
+    uint32_t micros;
+    uint16_t seq;
+    int16_t ddist0_mm;
+    int16_t ddist1_mm;
+    int16_t ddist2_mm;
+};
+
+// Naturally packed: wire layout is the in-memory layout
+#if MSG_LITTLE_ENDIAN
+static_assert(sizeof(MsgOdomAll) == 12, "MsgOdomAll: unexpected padding");
+static_assert(offsetof(MsgOdomAll, micros) == 0, "MsgOdomAll: unexpected offset of micros");
+static_assert(offsetof(MsgOdomAll, seq) == 4, "MsgOdomAll: unexpected offset of seq");
+static_assert(offsetof(MsgOdomAll, ddist0_mm) == 6, "MsgOdomAll: unexpected offset of ddist0_mm");
+static_assert(offsetof(MsgOdomAll, ddist1_mm) == 8, "MsgOdomAll: unexpected offset of ddist1_mm");
+static_assert(offsetof(MsgOdomAll, ddist2_mm) == 10, "MsgOdomAll: unexpected offset of ddist2_mm");
+#endif
+
+static inline size_t parse_MsgOdomAll(MsgOdomAll* __restrict__ out, const char* __restrict__ src, size_t size) {
+    if (size < 12) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(out, src, 12);
+#else
+    memcpy(&out->micros, src, sizeof(out->micros));
+    src += sizeof(out->micros);
+    memcpy(&out->seq, src, sizeof(out->seq));
+    src += sizeof(out->seq);
+    memcpy(&out->ddist0_mm, src, sizeof(out->ddist0_mm));
+    src += sizeof(out->ddist0_mm);
+    memcpy(&out->ddist1_mm, src, sizeof(out->ddist1_mm));
+    src += sizeof(out->ddist1_mm);
+    memcpy(&out->ddist2_mm, src, sizeof(out->ddist2_mm));
+    src += sizeof(out->ddist2_mm);
+#endif
+    return 12;
+}
+
+static inline size_t dump_MsgOdomAll(const MsgOdomAll* __restrict__ obj, char* __restrict__ buff, size_t size) {
+    if (size < 12) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(buff, obj, 12);
+#else
+    memcpy(buff, &obj->micros, sizeof(obj->micros));
+    buff += sizeof(obj->micros);
+    memcpy(buff, &obj->seq, sizeof(obj->seq));
+    buff += sizeof(obj->seq);
+    memcpy(buff, &obj->ddist0_mm, sizeof(obj->ddist0_mm));
+    buff += sizeof(obj->ddist0_mm);
+    memcpy(buff, &obj->ddist1_mm, sizeof(obj->ddist1_mm));
+    buff += sizeof(obj->ddist1_mm);
+    memcpy(buff, &obj->ddist2_mm, sizeof(obj->ddist2_mm));
+    buff += sizeof(obj->ddist2_mm);
+#endif
+    return 12;
+}
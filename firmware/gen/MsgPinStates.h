@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef float float32_t;
+typedef double float64_t;
+
+#ifndef MSG_LITTLE_ENDIAN
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MSG_LITTLE_ENDIAN 1
+#else
+#define MSG_LITTLE_ENDIAN 0
+#endif
+#endif
+
+typedef enum {
+    MsgPinStates_Type = 19,
+} MsgPinStates_;
+
+struct MsgPinStates {
+    uint32_t micros;
+    uint16_t states;
+    uint16_t changed;
+};
+
+// Naturally packed: wire layout is the in-memory layout
+#if MSG_LITTLE_ENDIAN
+static_assert(sizeof(MsgPinStates) == 8, "MsgPinStates: unexpected padding");
+static_assert(offsetof(MsgPinStates, micros) == 0, "MsgPinStates: unexpected offset of micros");
+static_assert(offsetof(MsgPinStates, states) == 4, "MsgPinStates: unexpected offset of states");
+static_assert(offsetof(MsgPinStates, changed) == 6, "MsgPinStates: unexpected offset of changed");
+#endif
+
+static inline size_t parse_MsgPinStates(MsgPinStates* __restrict__ out, const char* __restrict__ src, size_t size) {
+    if (size < 8) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(out, src, 8);
+#else
+    memcpy(&out->micros, src, sizeof(out->micros));
+    src += sizeof(out->micros);
+    memcpy(&out->states, src, sizeof(out->states));
+    src += sizeof(out->states);
+    memcpy(&out->changed, src, sizeof(out->changed));
+    src += sizeof(out->changed);
+#endif
+    return 8;
+}
+
+static inline size_t dump_MsgPinStates(const MsgPinStates* __restrict__ obj, char* __restrict__ buff, size_t size) {
+    if (size < 8) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(buff, obj, 8);
+#else
+    memcpy(buff, &obj->micros, sizeof(obj->micros));
+    buff += sizeof(obj->micros);
+    memcpy(buff, &obj->states, sizeof(obj->states));
+    buff += sizeof(obj->states);
+    memcpy(buff, &obj->changed, sizeof(obj->changed));
+    buff += sizeof(obj->changed);
+#endif
+    return 8;
+}
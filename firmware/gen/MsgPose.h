@@ -0,0 +1,49 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef float float32_t;
+typedef double float64_t;
+
+typedef enum {
+    MsgPose_Type = 14,
+} MsgPose_;
+
+struct MsgPose {
+    uint32_t micros;
+    uint16_t seq;
+    float32_t x;
+    float32_t y;
+    float32_t theta;
+};
+
+static inline size_t parse_MsgPose(MsgPose* __restrict__ out, const char* __restrict__ src, size_t size) {
+    if (size < 18) return 0;
+    memcpy(&out->micros, src, sizeof(out->micros));
+    src += sizeof(out->micros);
+    memcpy(&out->seq, src, sizeof(out->seq));
+    src += sizeof(out->seq);
+    memcpy(&out->x, src, sizeof(out->x));
+    src += sizeof(out->x);
+    memcpy(&out->y, src, sizeof(out->y));
+    src += sizeof(out->y);
+    memcpy(&out->theta, src, sizeof(out->theta));
+    src += sizeof(out->theta);
+    return 18;
+}
+
+static inline size_t dump_MsgPose(const MsgPose* __restrict__ obj, char* __restrict__ buff, size_t size) {
+    if (size < 18) return 0;
+    memcpy(buff, &obj->micros, sizeof(obj->micros));
+    buff += sizeof(obj->micros);
+    memcpy(buff, &obj->seq, sizeof(obj->seq));
+    buff += sizeof(obj->seq);
+    memcpy(buff, &obj->x, sizeof(obj->x));
+    buff += sizeof(obj->x);
+    memcpy(buff, &obj->y, sizeof(obj->y));
+    buff += sizeof(obj->y);
+    memcpy(buff, &obj->theta, sizeof(obj->theta));
+    buff += sizeof(obj->theta);
+    return 18;
+}
@@ -6,6 +6,14 @@
 typedef float float32_t;
 typedef double float64_t;
 
+#ifndef MSG_LITTLE_ENDIAN
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MSG_LITTLE_ENDIAN 1
+#else
+#define MSG_LITTLE_ENDIAN 0
+#endif
+#endif
+
 typedef enum {
     MsgReadPin_Type = 12,
 } MsgReadPin_;
@@ -16,24 +24,40 @@ struct MsgReadPin {
     int8_t pullup;
 };
 
+// Naturally packed: wire layout is the in-memory layout
+#if MSG_LITTLE_ENDIAN
+static_assert(sizeof(MsgReadPin) == 3, "MsgReadPin: unexpected padding");
+static_assert(offsetof(MsgReadPin, pin) == 0, "MsgReadPin: unexpected offset of pin");
+static_assert(offsetof(MsgReadPin, value) == 1, "MsgReadPin: unexpected offset of value");
+static_assert(offsetof(MsgReadPin, pullup) == 2, "MsgReadPin: unexpected offset of pullup");
+#endif
+
 static inline size_t parse_MsgReadPin(MsgReadPin* __restrict__ out, const char* __restrict__ src, size_t size) {
     if (size < 3) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(out, src, 3);
+#else
     memcpy(&out->pin, src, sizeof(out->pin));
     src += sizeof(out->pin);
     memcpy(&out->value, src, sizeof(out->value));
     src += sizeof(out->value);
     memcpy(&out->pullup, src, sizeof(out->pullup));
     src += sizeof(out->pullup);
+#endif
     return 3;
 }
 
 static inline size_t dump_MsgReadPin(const MsgReadPin* __restrict__ obj, char* __restrict__ buff, size_t size) {
     if (size < 3) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(buff, obj, 3);
+#else
     memcpy(buff, &obj->pin, sizeof(obj->pin));
     buff += sizeof(obj->pin);
     memcpy(buff, &obj->value, sizeof(obj->value));
     buff += sizeof(obj->value);
     memcpy(buff, &obj->pullup, sizeof(obj->pullup));
     buff += sizeof(obj->pullup);
+#endif
     return 3;
 }
@@ -0,0 +1,69 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef float float32_t;
+typedef double float64_t;
+
+#ifndef MSG_LITTLE_ENDIAN
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MSG_LITTLE_ENDIAN 1
+#else
+#define MSG_LITTLE_ENDIAN 0
+#endif
+#endif
+
+typedef enum {
+    MsgSubscribePin_Type = 18,
+} MsgSubscribePin_;
+
+struct MsgSubscribePin {
+    uint8_t slot;
+    int8_t pin;
+    uint8_t debounceMs;
+    uint8_t pullup;
+};
+
+// Naturally packed: wire layout is the in-memory layout
+#if MSG_LITTLE_ENDIAN
+static_assert(sizeof(MsgSubscribePin) == 4, "MsgSubscribePin: unexpected padding");
+static_assert(offsetof(MsgSubscribePin, slot) == 0, "MsgSubscribePin: unexpected offset of slot");
+static_assert(offsetof(MsgSubscribePin, pin) == 1, "MsgSubscribePin: unexpected offset of pin");
+static_assert(offsetof(MsgSubscribePin, debounceMs) == 2, "MsgSubscribePin: unexpected offset of debounceMs");
+static_assert(offsetof(MsgSubscribePin, pullup) == 3, "MsgSubscribePin: unexpected offset of pullup");
+#endif
+
+static inline size_t parse_MsgSubscribePin(MsgSubscribePin* __restrict__ out, const char* __restrict__ src, size_t size) {
+    if (size < 4) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(out, src, 4);
+#else
+    memcpy(&out->slot, src, sizeof(out->slot));
+    src += sizeof(out->slot);
+    memcpy(&out->pin, src, sizeof(out->pin));
+    src += sizeof(out->pin);
+    memcpy(&out->debounceMs, src, sizeof(out->debounceMs));
+    src += sizeof(out->debounceMs);
+    memcpy(&out->pullup, src, sizeof(out->pullup));
+    src += sizeof(out->pullup);
+#endif
+    return 4;
+}
+
+static inline size_t dump_MsgSubscribePin(const MsgSubscribePin* __restrict__ obj, char* __restrict__ buff, size_t size) {
+    if (size < 4) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(buff, obj, 4);
+#else
+    memcpy(buff, &obj->slot, sizeof(obj->slot));
+    buff += sizeof(obj->slot);
+    memcpy(buff, &obj->pin, sizeof(obj->pin));
+    buff += sizeof(obj->pin);
+    memcpy(buff, &obj->debounceMs, sizeof(obj->debounceMs));
+    buff += sizeof(obj->debounceMs);
+    memcpy(buff, &obj->pullup, sizeof(obj->pullup));
+    buff += sizeof(obj->pullup);
+#endif
+    return 4;
+}
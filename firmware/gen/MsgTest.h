@@ -6,6 +6,14 @@
 typedef float float32_t;
 typedef double float64_t;
 
+#ifndef MSG_LITTLE_ENDIAN
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MSG_LITTLE_ENDIAN 1
+#else
+#define MSG_LITTLE_ENDIAN 0
+#endif
+#endif
+
 typedef enum {
     MsgTest_Type = 7,
 } MsgTest_;
@@ -14,16 +22,30 @@ struct MsgTest {
     uint8_t led;
 };
 
+// Naturally packed: wire layout is the in-memory layout
+#if MSG_LITTLE_ENDIAN
+static_assert(sizeof(MsgTest) == 1, "MsgTest: unexpected padding");
+static_assert(offsetof(MsgTest, led) == 0, "MsgTest: unexpected offset of led");
+#endif
+
 static inline size_t parse_MsgTest(MsgTest* __restrict__ out, const char* __restrict__ src, size_t size) {
     if (size < 1) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(out, src, 1);
+#else
     memcpy(&out->led, src, sizeof(out->led));
     src += sizeof(out->led);
+#endif
     return 1;
 }
 
 static inline size_t dump_MsgTest(const MsgTest* __restrict__ obj, char* __restrict__ buff, size_t size) {
     if (size < 1) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(buff, obj, 1);
+#else
     memcpy(buff, &obj->led, sizeof(obj->led));
     buff += sizeof(obj->led);
+#endif
     return 1;
 }
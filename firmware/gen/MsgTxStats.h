@@ -0,0 +1,57 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef float float32_t;
+typedef double float64_t;
+
+#ifndef MSG_LITTLE_ENDIAN
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MSG_LITTLE_ENDIAN 1
+#else
+#define MSG_LITTLE_ENDIAN 0
+#endif
+#endif
+
+typedef enum {
+    MsgTxStats_Type = 11,
+} MsgTxStats_;
+
+struct MsgTxStats {
+    uint16_t overflows;
+    uint16_t peak;
+};
+
+// Naturally packed: wire layout is the in-memory layout
+#if MSG_LITTLE_ENDIAN
+static_assert(sizeof(MsgTxStats) == 4, "MsgTxStats: unexpected padding");
+static_assert(offsetof(MsgTxStats, overflows) == 0, "MsgTxStats: unexpected offset of overflows");
+static_assert(offsetof(MsgTxStats, peak) == 2, "MsgTxStats: unexpected offset of peak");
+#endif
+
+static inline size_t parse_MsgTxStats(MsgTxStats* __restrict__ out, const char* __restrict__ src, size_t size) {
+    if (size < 4) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(out, src, 4);
+#else
+    memcpy(&out->overflows, src, sizeof(out->overflows));
+    src += sizeof(out->overflows);
+    memcpy(&out->peak, src, sizeof(out->peak));
+    src += sizeof(out->peak);
+#endif
+    return 4;
+}
+
+static inline size_t dump_MsgTxStats(const MsgTxStats* __restrict__ obj, char* __restrict__ buff, size_t size) {
+    if (size < 4) return 0;
+#if MSG_LITTLE_ENDIAN
+    memcpy(buff, obj, 4);
+#else
+    memcpy(buff, &obj->overflows, sizeof(obj->overflows));
+    buff += sizeof(obj->overflows);
+    memcpy(buff, &obj->peak, sizeof(obj->peak));
+    buff += sizeof(obj->peak);
+#endif
+    return 4;
+}
@@ -7,9 +7,19 @@
 
 #include "gen/MsgConfigMotor.h"
 #include "gen/MsgConfigPinout.h"
+#include "fixed.hpp"
+#include "encoder.hpp"
 
 #define MAX_PWM 255
+// Integral clamp in m*s (float m/s errors times seconds), both PID paths
+#ifndef MAX_INTER_TERM
 #define MAX_INTER_TERM 30000
+#endif
+
+// Speed estimation and PID in Q16.16 millimeters instead of float meters
+#ifndef MOTOR_FIXED_POINT
+#define MOTOR_FIXED_POINT 1
+#endif
 
 static inline float toRadians(float degrees)
 {
@@ -20,41 +30,110 @@ class Motor
 {
 public:
     using Callback = void (*)();
+#if MOTOR_FIXED_POINT
+    // Q16.16 mm and mm/s
+    using Dist = q16_t;
+    using Speed = q16_t;
+#else
+    // m and m/s
+    using Dist = float;
+    using Speed = float;
+#endif
 
     Motor() = default;
+    // Nominal control period, Update() must be called at this rate
+    void SetPeriod(uint32_t micros) {
+        periodUs = micros;
+#if MOTOR_FIXED_POINT
+        precompute();
+#endif
+    }
     void SetPinout(Callback cb, MsgConfigPinout const &_pinout) {
         if (pinout.encoderA) {
             detachInterrupt(digitalPinToInterrupt(pinout.encoderA));
+            detachEncoderB();
         }
         this->pinout = _pinout;
+        pinMode(pinout.encoderA, INPUT);
         pinMode(pinout.encoderB, INPUT);
         pinMode(pinout.enable, OUTPUT);
         pinMode(pinout.fwd, OUTPUT);
         pinMode(pinout.back, OUTPUT);
+        encA.Set(pinout.encoderA);
+        encB.Set(pinout.encoderB);
+        encState = (encA.Read() << 1) | encB.Read();
+#if ENCODER_DECODING == 1
         attachInterrupt(digitalPinToInterrupt(pinout.encoderA), cb, RISING);
+#else
+        attachInterrupt(digitalPinToInterrupt(pinout.encoderA), cb, CHANGE);
+#endif
+#if ENCODER_DECODING == 4
+        auto b = pinout.encoderB;
+        decoding = 4;
+        if (digitalPinToInterrupt(b) != NOT_AN_INTERRUPT) {
+            attachInterrupt(digitalPinToInterrupt(b), cb, CHANGE);
+#if defined(PCICR)
+        } else if (digitalPinToPCICR(b)) {
+            *digitalPinToPCMSK(b) |= bit(digitalPinToPCMSKbit(b));
+            *digitalPinToPCICR(b) |= bit(digitalPinToPCICRbit(b));
+#endif
+        } else {
+            decoding = 2;
+        }
+#if MOTOR_FIXED_POINT
+        precompute();
+#endif
+#endif
+    }
+    // Called from encoder ISRs of this motor
+    inline void EncoderEdge() noexcept {
+#if ENCODER_DECODING == 1
+        X += encB.Read() ? 1 : -1;
+#else
+        uint8_t curr = (encA.Read() << 1) | encB.Read();
+        if (decoding == 4) {
+            X += QuadratureTable[(encState << 2) | curr];
+        } else if (curr != encState) {
+            // Edges of A only: direction from A == B
+            X += (curr == 0 || curr == 3) ? 1 : -1;
+        }
+        encState = curr;
+#endif
     }
     void SetParams(const MsgConfigMotor &initStruct)
     {
         params = initStruct;
         xCoeff = cos(toRadians(initStruct.angleDegrees));
         yCoeff = sin(toRadians(initStruct.angleDegrees));
+#if MOTOR_FIXED_POINT
+        precompute();
+#endif
     }
-    float Update()
+    // Returns distance travelled since last call
+    Dist Update()
     {
         if (!enabled) {
-            dX = X = 0;
+            dX = 0;
+            lastX = 0;
+            EncoderReset(X);
             digitalWrite(pinout.enable, HIGH);
             digitalWrite(pinout.fwd, HIGH);
             digitalWrite(pinout.back, HIGH);
             return 0;
         }
-        auto current = millis();
-        dTime = (current - lastMillis) / 1000.0;
-        lastMillis = current;
-        dX = static_cast<int>(X - lastX);
-        lastX = X;
-        ddist = dX * (params.radius / params.ticksPerRotation) * params.coeff;
-        currSpd = ddist / dTime;
+        auto x = EncoderSnapshot(X);
+        dX = static_cast<int>(static_cast<int32_t>(x - lastX));
+        lastX = x;
+#if MOTOR_FIXED_POINT
+        ddist = dX * mmPerTick;
+        currSpd = q16Mul(ddist, rate);
+#else
+        auto current = micros();
+        dTime = (current - lastMicros) / 1000000.f;
+        lastMicros = current;
+        ddist = dX * (params.radius / ticksPerRotation()) * params.coeff;
+        currSpd = dTime > 0 ? ddist / dTime : 0;
+#endif
         if (stopped)
         {
             digitalWrite(pinout.enable, HIGH);
@@ -80,13 +159,75 @@ public:
         return ddist;
     }
 
-    void SpeedCallback(float x, float y, float turn) noexcept {
+    static int16_t ToMmPerSec(Speed spd) noexcept {
+#if MOTOR_FIXED_POINT
+        return q16Trunc(spd);
+#else
+        return spd * 1000.f;
+#endif
+    }
+    static Speed FromMmPerSec(int16_t mm) noexcept {
+#if MOTOR_FIXED_POINT
+        return q16_t(mm) * Q16_ONE;
+#else
+        return mm / 1000.f;
+#endif
+    }
+
+    static float ToMeters(Dist d) noexcept {
+#if MOTOR_FIXED_POINT
+        return q16ToFloat(d) / 1000.f;
+#else
+        return d;
+#endif
+    }
+
+    // Takes whole millimeters out of accumulated distance, remainder stays
+    static int16_t TakeMillimeters(Dist& acc) noexcept {
+#if MOTOR_FIXED_POINT
+        int16_t mm = q16Trunc(acc);
+        acc -= q16_t(mm) * Q16_ONE;
+#else
+        int16_t mm = acc * 1000.f;
+        acc -= mm / 1000.f;
+#endif
+        return mm;
+    }
+
+    // Gains as in MsgConfigMotor
+    void SetGains(float prop, float inter, float diff) noexcept {
+        params.propCoeff = prop;
+        params.interCoeff = inter;
+        params.diffCoeff = diff;
+        termsReset();
+#if MOTOR_FIXED_POINT
+        precompute();
+#endif
+    }
+
+    // Wheel speed step, bypassing the robot frame mapping
+    void SetTarget(Speed spd) noexcept {
         if (!enabled) return;
-        float spd = xCoeff * x * params.maxSpeed + yCoeff * y * params.maxSpeed;
-        spd += turn * params.turnMaxSpeed;
-        lastSpd = targSpd;
+        termsReset();
+        stopped = spd == 0;
+        targSpd = spd;
+        lastSpd = spd;
+    }
+
+    // Inputs are normalized speeds in thousandths
+    void SpeedCallback(int16_t x, int16_t y, int16_t turn) noexcept {
+        if (!enabled) return;
+#if MOTOR_FIXED_POINT
+        Speed spd = x * xSpeed + y * ySpeed + turn * turnSpeed;
+        //////IF speed is less than 10 mm/second then its not considered and PID terms are reset
+        auto speedTooLow = -10 * Q16_ONE < spd && spd < 10 * Q16_ONE;
+#else
+        float spd = (xCoeff * x * params.maxSpeed + yCoeff * y * params.maxSpeed) / 1000.f;
+        spd += turn * params.turnMaxSpeed / 1000.f;
         //////IF speed is less than 1 cm/second then its not considered and PID terms are reset
         auto speedTooLow = -0.01 < spd && spd < 0.01;
+#endif
+        lastSpd = targSpd;
         auto lastPositive = lastSpd > 0;
         auto newPositive = spd > 0;
         auto shouldResetTerms = newPositive != lastPositive;
@@ -107,46 +248,128 @@ public:
     }
 
     // TODO: Sepate fields into anon structs
-    volatile unsigned long X = {};
-    float targSpd = {};
-    float currSpd = {};
+    // Wraps around: edges are counted modulo 2^32, only deltas are signed
+    volatile uint32_t X = {};
+    Speed targSpd = {};
+    Speed currSpd = {};
     int dX = {};
     int pwm = {};
     const MsgConfigPinout &GetPinout() const noexcept {
         return pinout;
     }
+    // Direction of the wheel in robot frame
+    float XCoeff() const noexcept {
+        return xCoeff;
+    }
+    float YCoeff() const noexcept {
+        return yCoeff;
+    }
 
 private:
+    // Configured ticks are per encoder period on A
+    float ticksPerRotation() const noexcept {
+        return float(params.ticksPerRotation) * decoding;
+    }
+    void detachEncoderB() noexcept {
+#if ENCODER_DECODING == 4
+        auto b = pinout.encoderB;
+        if (digitalPinToInterrupt(b) != NOT_AN_INTERRUPT) {
+            detachInterrupt(digitalPinToInterrupt(b));
+#if defined(PCICR)
+        } else if (digitalPinToPCICR(b)) {
+            *digitalPinToPCMSK(b) &= ~bit(digitalPinToPCMSKbit(b));
+#endif
+        }
+#endif
+    }
     void termsReset() noexcept {
         lastError = 0;
         interTerm = 0;
     }
+#if MOTOR_FIXED_POINT
+    // Reciprocals and unit conversions, so that a tick only multiplies
+    void precompute() noexcept
+    {
+        if (!params.ticksPerRotation || !periodUs) {
+            return;
+        }
+        float hz = 1000000.f / periodUs;
+        mmPerTick = q16FromFloat(params.radius * 1000.f / ticksPerRotation() * params.coeff);
+        rate = q16FromFloat(hz);
+        dt = q16FromFloat(1.f / hz);
+        // Gains are configured against m/s
+        kp = q16FromFloat(params.propCoeff / 1000.f);
+        ki = q16FromFloat(params.interCoeff / 1000.f);
+        kdRate = q16FromFloat(params.diffCoeff / 1000.f * hz);
+        xSpeed = q16FromFloat(xCoeff * params.maxSpeed);
+        ySpeed = q16FromFloat(yCoeff * params.maxSpeed);
+        turnSpeed = q16FromFloat(params.turnMaxSpeed);
+    }
+    void PID() noexcept
+    {
+        q16_t error = targSpd - currSpd;
+        interTerm += q16Mul(error, dt);
+        interTerm = constrain(interTerm, -MaxInterTerm, MaxInterTerm);
+        int64_t out = int64_t(error) * kp +
+                      interTerm * ki -
+                      int64_t(error - lastError) * kdRate;
+        lastError = error;
+        out >>= 32;
+        pwm = constrain(out, -MAX_PWM, MAX_PWM);
+    }
+#else
     void PID() noexcept
     {
         float error = targSpd - currSpd;
         interTerm += dTime * error;
+        float diff = dTime > 0 ? (error - lastError) / dTime : 0;
         pwm = error * params.propCoeff +
               interTerm * params.interCoeff -
-              (error - lastError) / dTime * params.diffCoeff;
+              diff * params.diffCoeff;
         interTerm = constrain(interTerm, -MAX_INTER_TERM, MAX_INTER_TERM);
         lastError = error;
         pwm = constrain(pwm, -MAX_PWM, MAX_PWM);
     }
+#endif
     /// @brief Params
     MsgConfigPinout pinout = {};
     MsgConfigMotor params;
-    float xCoeff;
-    float yCoeff;
-    /// @brief Non Const States
-    float ddist = {};
-    float lastSpd = {};
-    unsigned long lastMillis = {};
+    float xCoeff = {};
+    float yCoeff = {};
+    uint32_t periodUs = {};
+#if MOTOR_FIXED_POINT
+    q16_t mmPerTick = {};
+    q16_t rate = {};
+    q16_t dt = {};
+    q16_t kp = {};
+    q16_t ki = {};
+    q16_t kdRate = {};
+    q16_t xSpeed = {};
+    q16_t ySpeed = {};
+    q16_t turnSpeed = {};
+#else
+    unsigned long lastMicros = {};
     float dTime = {};
+#endif
+    /// @brief Non Const States
+    Dist ddist = {};
+    Speed lastSpd = {};
     /// @brief PID States
-    float interTerm = {};
-    float lastError = {};
+#if MOTOR_FIXED_POINT
+    // Q48.16 mm*s: the clamp does not fit Q16.16. interTerm * ki stays in
+    // int64 for interCoeff below ~60000
+    static constexpr int64_t MaxInterTerm = int64_t(MAX_INTER_TERM) * 1000 * Q16_ONE;
+    int64_t interTerm = {};
+#else
+    Dist interTerm = {};
+#endif
+    Speed lastError = {};
     /// @brief Encoder states
-    unsigned long lastX = {};
+    uint32_t lastX = {};
+    FastPin encA;
+    FastPin encB;
+    uint8_t encState = {};
+    uint8_t decoding = ENCODER_DECODING;
     bool stopped = {};
     bool enabled = {true};
 };
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+#include "motor.hpp"
+#include "gen/MsgConfigPose.h"
+#include "gen/MsgPose.h"
+
+// Pose integrated on the control tick with the same geometry as
+// script/odom.py, xCoeff/yCoeff scaling the body frame, in midpoint steps
+// instead of Euler ones. Heading is tracked as (cos, sin) rotated by small
+// angles, so a tick needs no trigonometry.
+struct PoseIntegrator {
+    MsgConfigPose conf = {};
+    float x = {};
+    float y = {};
+
+    void Configure(MsgConfigPose const& _conf) noexcept {
+        conf = _conf;
+        if (conf.reset) {
+            x = y = 0;
+            c = 1;
+            s = 0;
+        }
+    }
+
+    // Call on a copy taken with interrupts disabled
+    void Fill(MsgPose& msg) const noexcept {
+        msg.x = x;
+        msg.y = y;
+        msg.theta = atan2(s, c);
+    }
+
+    void Step(const Motor::Dist* ddists, const Motor* motors, uint8_t count) noexcept {
+        if (!conf.enable || conf.baseRadius <= 0) {
+            return;
+        }
+        float bx = 0, by = 0, sum = 0;
+        for (uint8_t i = 0; i < count; ++i) {
+            float d = Motor::ToMeters(ddists[i]);
+            bx += d * motors[i].XCoeff();
+            by += d * motors[i].YCoeff();
+            sum += d;
+        }
+        bx *= 2.f / count * conf.xCoeff;
+        by *= 2.f / count * conf.yCoeff;
+        float dth = sum / count / conf.baseRadius * conf.thetaCoeff;
+        // Move along the heading at mid-step
+        float h = dth / 2;
+        float mc = c - s * h;
+        float ms = s + c * h;
+        x += mc * bx - ms * by;
+        y += ms * bx + mc * by;
+        float h2 = dth * dth / 2;
+        float nc = c - s * dth - c * h2;
+        float ns = s + c * dth - s * h2;
+        // One Newton step keeps (c, s) on the unit circle
+        float k = 1.5f - 0.5f * (nc * nc + ns * ns);
+        c = nc * k;
+        s = ns * k;
+    }
+
+private:
+    float c = 1;
+    float s = 0;
+};
@@ -0,0 +1,347 @@
+#pragma once
+#include "scan.hpp"
+#include "odom.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <mutex>
+
+namespace bang
+{
+
+struct Cluster {
+    // Centroid, sensor frame
+    float x{};
+    float y{};
+    // Distance between the first and the last point
+    float extent{};
+    float intensity{};
+    uint32_t count{};
+    // Index range in the scan, last inclusive
+    uint32_t first{};
+    uint32_t last{};
+};
+
+// Breaks the angle-ordered scan wherever two consecutive returns are further
+// apart than gap + gapRatio * range * dTheta (adaptive breakpoint), so
+// clustering is one linear walk instead of a neighbour search.
+struct Segmenter {
+    struct Params {
+        double minRange = 0.05;
+        double maxRange = 12;
+        double gap = 0.1;
+        double gapRatio = 3;
+        size_t minPoints = 3;
+        size_t maxPoints = 400;
+        double maxExtent = 1.5;
+    };
+
+    Params params;
+
+    void Segment(Scan const& scan, vector<Cluster>& out) const {
+        out.clear();
+        Cluster cur;
+        const ParsedNode* prev = nullptr;
+        double sx = 0, sy = 0, si = 0;
+        auto flush = [&]{
+            if (cur.count) {
+                cur.x = float(sx / cur.count);
+                cur.y = float(sy / cur.count);
+                cur.intensity = float(si / cur.count);
+                out.push_back(cur);
+            }
+            cur = {};
+            sx = sy = si = 0;
+        };
+        for (uint32_t i = 0; i < scan.size(); ++i) {
+            auto& n = scan[i];
+            if (n.range < params.minRange || n.range > params.maxRange) {
+                continue;
+            }
+            if (prev && !adjacent(*prev, n)) {
+                flush();
+            }
+            if (!cur.count) {
+                cur.first = i;
+            }
+            cur.last = i;
+            cur.count++;
+            sx += n.x;
+            sy += n.y;
+            si += n.intensity;
+            prev = &n;
+        }
+        flush();
+        // The scan is a circle: first and last clusters may be one
+        if (out.size() > 1 && adjacent(scan[out.back().last], scan[out.front().first])) {
+            auto& a = out.back();
+            auto& b = out.front();
+            auto total = float(a.count + b.count);
+            b.x = (a.x * float(a.count) + b.x * float(b.count)) / total;
+            b.y = (a.y * float(a.count) + b.y * float(b.count)) / total;
+            b.intensity = (a.intensity * float(a.count) + b.intensity * float(b.count)) / total;
+            b.count += a.count;
+            b.first = a.first;
+            out.pop_back();
+        }
+        for (auto& c: out) {
+            auto& a = scan[c.first];
+            auto& b = scan[c.last];
+            c.extent = std::hypot(a.x - b.x, a.y - b.y);
+        }
+        out.erase(std::remove_if(out.begin(), out.end(), [&](Cluster const& c){
+            return c.count < params.minPoints || c.count > params.maxPoints || c.extent > params.maxExtent;
+        }), out.end());
+    }
+
+private:
+    bool adjacent(ParsedNode const& a, ParsedNode const& b) const noexcept {
+        auto dth = std::abs(std::remainder(double(b.relTheta) - double(a.relTheta), 2 * M_PI));
+        auto limit = params.gap + params.gapRatio * std::min(a.range, b.range) * dth;
+        return std::hypot(a.x - b.x, a.y - b.y) <= limit;
+    }
+};
+
+// Constant velocity Kalman filter per target, greedy nearest-neighbour
+// association within a gate
+struct Tracker {
+    struct Params {
+        // Association gate, meters
+        double gate = 0.5;
+        // Acceleration noise, m/s^2
+        double accel = 2;
+        // Measurement noise, meters
+        double measurement = 0.05;
+        size_t confirmHits = 3;
+        size_t maxMissed = 5;
+    };
+
+    struct Track {
+        uint32_t id;
+        // x, y, vx, vy
+        std::array<double, 4> s;
+        std::array<double, 16> P;
+        double extent;
+        uint32_t age;
+        uint32_t hits;
+        uint32_t missed;
+        bool confirmed;
+    };
+
+    Params params;
+
+    // Points in the tracking frame
+    void Step(double t, const double* xs, const double* ys, const float* extents, size_t count) {
+        auto dt = started ? std::clamp(t - last, 0., 1.) : 0.;
+        started = true;
+        last = t;
+        for (auto& tr: tracks) {
+            predict(tr, dt);
+        }
+        pairs.clear();
+        auto gate2 = params.gate * params.gate;
+        for (uint32_t ti = 0; ti < tracks.size(); ++ti) {
+            for (uint32_t mi = 0; mi < count; ++mi) {
+                auto dx = xs[mi] - tracks[ti].s[0];
+                auto dy = ys[mi] - tracks[ti].s[1];
+                auto d = dx * dx + dy * dy;
+                if (d <= gate2) {
+                    pairs.push_back({d, ti, mi});
+                }
+            }
+        }
+        std::sort(pairs.begin(), pairs.end(), [](Pair const& a, Pair const& b){ return a.d < b.d; });
+        trackUsed.assign(tracks.size(), false);
+        measUsed.assign(count, false);
+        for (auto& p: pairs) {
+            if (trackUsed[p.track] || measUsed[p.meas]) {
+                continue;
+            }
+            trackUsed[p.track] = measUsed[p.meas] = true;
+            auto& tr = tracks[p.track];
+            update(tr, xs[p.meas], ys[p.meas]);
+            tr.extent = extents[p.meas];
+            tr.hits++;
+            tr.missed = 0;
+            tr.confirmed = tr.confirmed || tr.hits >= params.confirmHits;
+        }
+        for (size_t i = 0; i < tracks.size(); ++i) {
+            if (!trackUsed[i]) {
+                tracks[i].missed++;
+            }
+            tracks[i].age++;
+        }
+        tracks.erase(std::remove_if(tracks.begin(), tracks.end(), [&](Track const& tr){
+            return tr.missed > params.maxMissed;
+        }), tracks.end());
+        auto r2 = params.measurement * params.measurement;
+        for (uint32_t mi = 0; mi < count; ++mi) {
+            if (measUsed[mi]) {
+                continue;
+            }
+            Track tr{};
+            tr.id = nextId++;
+            tr.s = {xs[mi], ys[mi], 0, 0};
+            // Unknown velocity: as if anything up to ~2 m/s
+            tr.P = {r2, 0, 0, 0,
+                    0, r2, 0, 0,
+                    0, 0, 4, 0,
+                    0, 0, 0, 4};
+            tr.extent = extents[mi];
+            tr.hits = 1;
+            tr.confirmed = params.confirmHits <= 1;
+            tracks.push_back(tr);
+        }
+    }
+
+    vector<Track> const& Tracks() const noexcept {
+        return tracks;
+    }
+
+private:
+    struct Pair {
+        double d;
+        uint32_t track;
+        uint32_t meas;
+    };
+
+    void predict(Track& tr, double dt) const noexcept {
+        if (dt <= 0) {
+            return;
+        }
+        tr.s[0] += tr.s[2] * dt;
+        tr.s[1] += tr.s[3] * dt;
+        // P = F P F^T + Q, axes are independent: (pos, vel) blocks per axis
+        auto q = params.accel * params.accel;
+        auto dt2 = dt * dt;
+        for (int a = 0; a < 2; ++a) {
+            auto& pp = tr.P[a * 4 + a];
+            auto& pv = tr.P[a * 4 + a + 2];
+            auto& vp = tr.P[(a + 2) * 4 + a];
+            auto& vv = tr.P[(a + 2) * 4 + a + 2];
+            pp += dt * (pv + vp) + dt2 * vv + q * dt2 * dt2 / 4;
+            pv += dt * vv + q * dt2 * dt / 2;
+            vp = pv;
+            vv += q * dt2;
+        }
+    }
+
+    void update(Track& tr, double mx, double my) const noexcept {
+        auto r2 = params.measurement * params.measurement;
+        double z[2] = {mx - tr.s[0], my - tr.s[1]};
+        // S = H P H^T + R, H picks the position
+        double s00 = tr.P[0] + r2, s01 = tr.P[1], s10 = tr.P[4], s11 = tr.P[5] + r2;
+        auto det = s00 * s11 - s01 * s10;
+        if (std::abs(det) < 1e-12) {
+            return;
+        }
+        double si[4] = {s11 / det, -s01 / det, -s10 / det, s00 / det};
+        // K = P H^T S^-1 (4x2)
+        double k[8];
+        for (int r = 0; r < 4; ++r) {
+            auto p0 = tr.P[r * 4 + 0], p1 = tr.P[r * 4 + 1];
+            k[r * 2 + 0] = p0 * si[0] + p1 * si[2];
+            k[r * 2 + 1] = p0 * si[1] + p1 * si[3];
+        }
+        for (int r = 0; r < 4; ++r) {
+            tr.s[r] += k[r * 2] * z[0] + k[r * 2 + 1] * z[1];
+        }
+        // P = (I - K H) P
+        std::array<double, 16> next;
+        for (int r = 0; r < 4; ++r) {
+            for (int c = 0; c < 4; ++c) {
+                next[r * 4 + c] = tr.P[r * 4 + c] - k[r * 2] * tr.P[c] - k[r * 2 + 1] * tr.P[4 + c];
+            }
+        }
+        tr.P = next;
+    }
+
+    vector<Track> tracks;
+    vector<Pair> pairs;
+    vector<bool> trackUsed;
+    vector<bool> measUsed;
+    uint32_t nextId = 1;
+    double last = 0;
+    bool started = false;
+};
+
+// Segments every scan and tracks the clusters, in the map frame when a pose
+// source is attached, in the sensor frame otherwise
+struct ClusterTracker final : ScanSink {
+    using PoseFn = std::function<Pose()>;
+
+    struct Params {
+        Segmenter::Params segment;
+        Tracker::Params track;
+        // Sensor pose in the frame of the pose source
+        double mountX = 0;
+        double mountY = 0;
+        double mountTh = 0;
+    };
+
+    ClusterTracker(Params params) : params(params) {
+        segmenter.params = params.segment;
+        tracker.params = params.track;
+    }
+
+    void AttachPose(PoseFn fn) {
+        std::atomic_store(&source, std::make_shared<const PoseFn>(std::move(fn)));
+    }
+
+    void Consume(Scan const& scan) override {
+        segmenter.Segment(scan, scratch);
+        Pose robot;
+        if (auto fn = std::atomic_load(&source)) {
+            robot = (*fn)();
+        }
+        auto c = std::cos(robot.th), s = std::sin(robot.th);
+        auto ox = robot.x + c * params.mountX - s * params.mountY;
+        auto oy = robot.y + s * params.mountX + c * params.mountY;
+        auto th = robot.th + params.mountTh;
+        auto sc = std::cos(th), ss = std::sin(th);
+        xs.resize(scratch.size());
+        ys.resize(scratch.size());
+        extents.resize(scratch.size());
+        for (size_t i = 0; i < scratch.size(); ++i) {
+            xs[i] = ox + sc * scratch[i].x - ss * scratch[i].y;
+            ys[i] = oy + ss * scratch[i].x + sc * scratch[i].y;
+            extents[i] = scratch[i].extent;
+        }
+        std::lock_guard lock(mtx);
+        tracker.Step(scan.t, xs.data(), ys.data(), extents.data(), scratch.size());
+        clusters.swap(scratch);
+        hits++;
+    }
+
+    vector<Cluster> Clusters() const {
+        std::lock_guard lock(mtx);
+        return clusters;
+    }
+
+    vector<Tracker::Track> Tracks() const {
+        std::lock_guard lock(mtx);
+        return tracker.Tracks();
+    }
+
+    uint64_t Hits() const {
+        std::lock_guard lock(mtx);
+        return hits;
+    }
+
+private:
+    Params params;
+    Segmenter segmenter;
+    Tracker tracker;
+    std::shared_ptr<const PoseFn> source;
+    vector<Cluster> clusters;
+    vector<Cluster> scratch;
+    vector<double> xs;
+    vector<double> ys;
+    vector<float> extents;
+    uint64_t hits = 0;
+    mutable std::mutex mtx;
+};
+
+}
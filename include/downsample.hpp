@@ -0,0 +1,123 @@
+#pragma once
+#include "scan.hpp"
+#include <array>
+#include <cmath>
+#include <exception>
+
+namespace bang
+{
+
+// Picks a subset of nodes as an index view, never copying them. Both modes
+// are one walk in angular order, keeping existing nodes only:
+// - voxel: first node of every voxel. Nodes of one voxel are consecutive
+//   in angle, so the voxels of the last few kept nodes replace a hash set;
+//   a voxel revisited much later in the scan may be kept twice.
+// - spacing: range adaptive, a node is kept once it is at least spacing
+//   away from the last kept one, so dense near-field returns are thinned
+//   while sparse far-field ones and edges all stay.
+struct Downsampler {
+    struct Params {
+        double voxel = 0;
+        double spacing = 0;
+        double minRange = 0.05;
+    };
+
+    Downsampler(Params params) : params(params) {
+        if ((params.voxel > 0) == (params.spacing > 0)) {
+            throw Err("Downsampler: set exactly one of voxel and spacing");
+        }
+    }
+
+    // Positions in scan.nodes, so views of views stay views of the raw scan
+    void Select(Scan const& scan, vector<uint32_t>& out) const {
+        out.clear();
+        auto minRange = float(params.minRange);
+        if (params.voxel > 0) {
+            auto inv = float(1 / params.voxel);
+            std::array<uint64_t, Recent> recent;
+            size_t seen = 0;
+            for (size_t i = 0; i < scan.size(); ++i) {
+                auto& n = scan[i];
+                if (n.range < minRange) {
+                    continue;
+                }
+                auto key = uint64_t(uint32_t(int32_t(std::floor(n.x * inv)))) << 32
+                         | uint32_t(int32_t(std::floor(n.y * inv)));
+                auto known = std::find(recent.begin(), recent.begin() + long(std::min(seen, Recent)), key);
+                if (known != recent.begin() + long(std::min(seen, Recent))) {
+                    continue;
+                }
+                recent[seen++ % Recent] = key;
+                out.push_back(scan.Index(i));
+            }
+        } else {
+            auto spacing2 = float(params.spacing * params.spacing);
+            const ParsedNode* last = nullptr;
+            for (size_t i = 0; i < scan.size(); ++i) {
+                auto& n = scan[i];
+                if (n.range < minRange) {
+                    continue;
+                }
+                if (last && (n.x - last->x) * (n.x - last->x) + (n.y - last->y) * (n.y - last->y) < spacing2) {
+                    continue;
+                }
+                last = &n;
+                out.push_back(scan.Index(i));
+            }
+        }
+    }
+
+private:
+    static constexpr size_t Recent = 8;
+
+    Params params;
+};
+
+// Feeds a downsampled view of every scan to its own sinks, next to sinks
+// attached to the driver directly, which keep seeing the raw scan
+struct Downsample final : ScanSink {
+    Downsample(Downsampler::Params params) : sampler(params) {}
+
+    void Attach(std::shared_ptr<ScanSink> sink) {
+        sinks.Attach(std::move(sink));
+    }
+
+    void Detach(std::shared_ptr<ScanSink> const& sink) {
+        sinks.Detach(sink);
+    }
+
+    void Consume(Scan const& scan) override {
+        sampler.Select(scan, index);
+        Scan view{scan.nodes, index.size(), scan.t, index.data()};
+        // Every sink runs; the first error is reported to the driver
+        std::exception_ptr first;
+        sinks.Run(view, [&](std::exception&){
+            if (!first) {
+                first = std::current_exception();
+            }
+        });
+        kept.store(index.size(), std::memory_order_relaxed);
+        hits.fetch_add(1, std::memory_order_relaxed);
+        if (first) {
+            std::rethrow_exception(first);
+        }
+    }
+
+    // Nodes in the latest view
+    size_t Kept() const noexcept {
+        return kept.load(std::memory_order_relaxed);
+    }
+
+    uint64_t Hits() const noexcept {
+        return hits.load(std::memory_order_relaxed);
+    }
+
+private:
+    Downsampler sampler;
+    SinkList sinks;
+    vector<uint32_t> index;
+    std::atomic<size_t> kept = 0;
+    std::atomic<uint64_t> hits = 0;
+};
+
+}
@@ -0,0 +1,201 @@
+#pragma once
+#include "scan.hpp"
+#include "uri.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace bang
+{
+
+// Per-node scan cleanup, applied while the driver converts raw nodes, so all
+// stages share one pass and dropped nodes never reach sinks or Python.
+// Polar() runs before the cartesian conversion, Cartesian() after it.
+//
+// DropShadows() needs the unfiltered neighbours of every node, so with it
+// enabled the driver converts through it: mixed pixels interpolated between a
+// foreground edge and the background form a segment almost along the line of
+// sight, and the farther node of such a pair is dropped.
+struct ScanFilter {
+    struct Params {
+        double minRange = 0;
+        double maxRange = INFINITY;
+        double minIntensity = 0;
+        // Robot outline in the sensor frame, returns inside are dropped
+        vector<std::pair<float, float>> footprint;
+        // Angular ranges [from, to) in relTheta radians to drop, may wrap
+        vector<std::pair<float, float>> sectors;
+        // Drop pairs seen at less than this from the line of sight, radians,
+        // 0 disables. Compared up to shadowWindow nodes apart, at most
+        // MaxShadowWindow.
+        double shadowAngle = 0;
+        size_t shadowWindow = 2;
+    };
+
+    ScanFilter(Params params) :
+        minRange(float(params.minRange)),
+        maxRange(float(params.maxRange)),
+        minIntensity(float(params.minIntensity)),
+        footprint(std::move(params.footprint)),
+        shadowTan(params.shadowAngle > 0 ? float(std::tan(params.shadowAngle)) : 0),
+        shadowWindow(std::min(params.shadowWindow, MaxShadowWindow))
+    {
+        for (auto [from, to]: params.sectors) {
+            from = wrap(from);
+            to = wrap(to);
+            if (from <= to) {
+                sectors.push_back({from, to});
+            } else {
+                sectors.push_back({from, float(2 * M_PI) + 1});
+                sectors.push_back({-1, to});
+            }
+        }
+        std::sort(sectors.begin(), sectors.end());
+        if (footprint.size() < 3) {
+            footprint.clear();
+        }
+        for (auto [x, y]: footprint) {
+            fx0 = std::min(fx0, x);
+            fx1 = std::max(fx1, x);
+            fy0 = std::min(fy0, y);
+            fy1 = std::max(fy1, y);
+        }
+    }
+
+    // URI params: min_range, max_range, min_intensity, mask=from:to,... in
+    // degrees, footprint=x:y,... in meters, shadow_angle in degrees,
+    // shadow_window
+    static Params Parse(map<string, string, std::less<>> const& params) {
+        Params res;
+        res.minRange = GetOr(params, "min_range", res.minRange);
+        res.maxRange = GetOr(params, "max_range", res.maxRange);
+        res.minIntensity = GetOr(params, "min_intensity", res.minIntensity);
+        auto pairs = [&](string_view key, auto& out, float scale) {
+            Split(GetOr(params, key, string{}), ',', [&](string_view item){
+                auto sep = item.find(':');
+                if (sep == string_view::npos) {
+                    throw Err("Invalid param: {}, expected a:b", key);
+                }
+                out.push_back({ParseNum<float>(item.substr(0, sep), key) * scale,
+                               ParseNum<float>(item.substr(sep + 1), key) * scale});
+            });
+        };
+        pairs("mask", res.sectors, float(M_PI / 180));
+        pairs("footprint", res.footprint, 1.f);
+        res.shadowAngle = GetOr(params, "shadow_angle", 0.) * M_PI / 180;
+        res.shadowWindow = GetOr(params, "shadow_window", res.shadowWindow);
+        return res;
+    }
+
+    static bool Configured(map<string, string, std::less<>> const& params) {
+        for (auto key: {"min_range", "max_range", "min_intensity", "mask", "footprint", "shadow_angle"}) {
+            if (params.count(key)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Nodes must come in ascending relTheta with cursor starting at 0
+    bool Polar(ParsedNode const& n, size_t& cursor) const noexcept {
+        if (n.range < minRange || n.range > maxRange || n.intensity < minIntensity) {
+            return false;
+        }
+        while (cursor < sectors.size() && n.relTheta >= sectors[cursor].second) {
+            cursor++;
+        }
+        return cursor == sectors.size() || n.relTheta < sectors[cursor].first;
+    }
+
+    bool Cartesian(ParsedNode const& n) const noexcept {
+        if (footprint.empty() || n.x < fx0 || n.x > fx1 || n.y < fy0 || n.y > fy1) {
+            return true;
+        }
+        // Even-odd crossings
+        bool inside = false;
+        for (size_t i = 0, j = footprint.size() - 1; i < footprint.size(); j = i++) {
+            auto [xi, yi] = footprint[i];
+            auto [xj, yj] = footprint[j];
+            if ((yi > n.y) != (yj > n.y) && n.x < (xj - xi) * (n.y - yi) / (yj - yi) + xi) {
+                inside = !inside;
+            }
+        }
+        return !inside;
+    }
+
+    bool Shadows() const noexcept {
+        return shadowTan > 0 && shadowWindow > 0;
+    }
+
+    static constexpr size_t MaxShadowWindow = 8;
+
+    // One pass over a full scan: convert(i, node) fills node i with x and y,
+    // emit(node) gets nodes that are not shadowed, in order. A node is held
+    // in a ring until the shadowWindow nodes after it were compared. The
+    // scan is closed, so the last nodes are compared with the first ones
+    // across the seam; those are converted twice.
+    template<typename Convert, typename Emit>
+    void DropShadows(size_t count, Convert const& convert, Emit const& emit) const {
+        constexpr size_t Ring = MaxShadowWindow + 1;
+        auto w = shadowWindow;
+        ParsedNode ring[Ring];
+        bool drop[Ring];
+        ParsedNode seam[MaxShadowWindow];
+        bool seamDrop[MaxShadowWindow] = {};
+        bool wrap = count > 2 * w;
+        if (wrap) {
+            for (size_t j = 0; j < w; ++j) {
+                convert(count - w + j, seam[j]);
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            auto& node = ring[i % Ring];
+            auto& nodeDrop = drop[i % Ring];
+            convert(i, node);
+            nodeDrop = wrap && i + w >= count ? seamDrop[i + w - count] : false;
+            for (size_t k = 1; k <= w; ++k) {
+                if (k <= i) {
+                    veil(ring[(i - k) % Ring], node, drop[(i - k) % Ring], nodeDrop);
+                } else if (wrap) {
+                    // i - k + count, last w nodes of the scan
+                    veil(seam[w + i - k], node, seamDrop[w + i - k], nodeDrop);
+                }
+            }
+            if (i >= w && !drop[(i - w) % Ring]) {
+                emit(ring[(i - w) % Ring]);
+            }
+        }
+        for (size_t i = count > w ? count - w : 0; i < count; ++i) {
+            if (!drop[i % Ring]) {
+                emit(ring[i % Ring]);
+            }
+        }
+    }
+
+private:
+    // a before b: |sin| < tan * |cos| of the angle between a's ray and a->b
+    void veil(ParsedNode const& a, ParsedNode const& b, bool& dropA, bool& dropB) const noexcept {
+        auto dx = b.x - a.x;
+        auto dy = b.y - a.y;
+        auto cross = std::abs(a.x * dy - a.y * dx);
+        auto dot = std::abs(a.x * dx + a.y * dy);
+        bool veiled = (cross < shadowTan * dot) & (a.range > 0) & (b.range > 0);
+        dropA |= veiled & (a.range > b.range);
+        dropB |= veiled & (b.range > a.range);
+    }
+
+    static float wrap(float theta) noexcept {
+        theta = std::fmod(theta, float(2 * M_PI));
+        return theta < 0 ? theta + float(2 * M_PI) : theta;
+    }
+
+    float minRange;
+    float maxRange;
+    float minIntensity;
+    vector<std::pair<float, float>> footprint;
+    float fx0 = INFINITY, fx1 = -INFINITY, fy0 = INFINITY, fy1 = -INFINITY;
+    float shadowTan;
+    size_t shadowWindow;
+    vector<std::pair<float, float>> sectors;
+};
+
+}
@@ -0,0 +1,313 @@
+#pragma once
+#include "scan.hpp"
+#include "odom.hpp"
+#include "reactor.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace bang
+{
+
+// Log-odds occupancy grid, unbounded: cells live in lazily allocated square
+// tiles, so a ray mostly stays within one tile. Log-odds are stored as
+// int16 thousandths. Tiles are never freed, views of them stay valid.
+//
+// Rays are cast with Bresenham. With a reactor, angular sectors are cast in
+// parallel in two passes (even, then odd sectors), so concurrently running
+// sectors are never adjacent; rays of non-adjacent sectors can only share
+// cells close to the sensor, and that part of every ray is cast afterwards
+// on the calling thread.
+struct OccupancyGrid final : ScanSink {
+    using Cell = int16_t;
+    static constexpr int TileBits = 6;
+    static constexpr int TileSize = 1 << TileBits;
+
+    struct Params {
+        // Meters per cell
+        double resolution = 0.05;
+        // Log-odds
+        double hit = 0.85;
+        double miss = -0.4;
+        double min = -2;
+        double max = 3.5;
+        double minRange = 0.05;
+        // Longer returns only clear space up to maxRange
+        double maxRange = 12;
+        // Sensor pose in the frame of the pose source
+        double mountX = 0;
+        double mountY = 0;
+        double mountTh = 0;
+        // Parallel sectors (even) when given a reactor, 0 or 1 casts on the
+        // driver thread only
+        unsigned sectors = 8;
+    };
+
+    struct Tile {
+        int32_t tx;
+        int32_t ty;
+        Cell cells[TileSize * TileSize];
+    };
+
+    using PoseFn = std::function<Pose()>;
+
+    OccupancyGrid(Params params, std::shared_ptr<Reactor> pool = nullptr) :
+        params(params),
+        pool(std::move(pool))
+    {
+        if (params.resolution <= 0) {
+            throw Err("OccupancyGrid: resolution must be positive");
+        }
+        if (this->params.sectors % 2) {
+            this->params.sectors++;
+        }
+        hit = toCell(params.hit);
+        miss = toCell(params.miss);
+        lo = toCell(params.min);
+        hi = toCell(params.max);
+    }
+
+    // Robot pose in the map frame for each scan, fixed pose if not attached
+    void AttachPose(PoseFn fn) {
+        std::atomic_store(&source, std::make_shared<const PoseFn>(std::move(fn)));
+    }
+
+    void SetPose(double x, double y, double th) {
+        std::atomic_store(&source, std::shared_ptr<const PoseFn>());
+        std::lock_guard lock(mtx);
+        fixed = {0, x, y, th};
+    }
+
+    void Consume(Scan const& scan) override {
+        Pose robot;
+        if (auto fn = std::atomic_load(&source)) {
+            robot = (*fn)();
+        } else {
+            std::lock_guard lock(mtx);
+            robot = fixed;
+        }
+        auto c = std::cos(robot.th);
+        auto s = std::sin(robot.th);
+        auto sx = robot.x + c * params.mountX - s * params.mountY;
+        auto sy = robot.y + s * params.mountX + c * params.mountY;
+        auto sth = robot.th + params.mountTh;
+        endpoints(scan, sx, sy, sth);
+        if (rays.empty()) {
+            return;
+        }
+        std::lock_guard lock(mtx);
+        allocate();
+        auto sectors = pool ? params.sectors : 0;
+        if (sectors < 2) {
+            for (auto& ray: rays) {
+                trace(ray, 0, INT32_MAX);
+            }
+        } else {
+            // Chebyshev steps from the sensor after which rays of non-adjacent
+            // sectors are at least two cells apart
+            auto half = M_PI / sectors;
+            auto near = int32_t(std::ceil(1 / std::sin(half))) + 1;
+            bounds.resize(sectors + 1);
+            for (unsigned i = 0; i <= sectors; ++i) {
+                auto theta = float(2 * M_PI * i / sectors);
+                bounds[i] = size_t(std::lower_bound(angles.begin(), angles.end(), theta) - angles.begin());
+            }
+            bounds[sectors] = rays.size();
+            for (unsigned parity = 0; parity < 2; ++parity) {
+                pool->ParallelFor(sectors / 2, [&](size_t i){
+                    auto sector = i * 2 + parity;
+                    for (auto r = bounds[sector]; r < bounds[sector + 1]; ++r) {
+                        trace(rays[r], near, INT32_MAX);
+                    }
+                });
+            }
+            for (auto& ray: rays) {
+                trace(ray, 0, near);
+            }
+        }
+        hits++;
+    }
+
+    // Tiles in allocation order, fn runs under the lock and must not keep them
+    template<typename F>
+    void EachTile(F const& fn) const {
+        std::lock_guard lock(mtx);
+        for (auto& tile: order) {
+            fn(*tile);
+        }
+    }
+
+    // Dense copy of all tiles, row-major (y, x) with cell (0, 0) at
+    // (originX, originY) in cells. Returns false if nothing was mapped yet.
+    bool Dense(vector<Cell>& out, int32_t& originX, int32_t& originY, int32_t& width, int32_t& height) const {
+        std::lock_guard lock(mtx);
+        if (order.empty()) {
+            return false;
+        }
+        int32_t tx0 = INT32_MAX, ty0 = INT32_MAX, tx1 = INT32_MIN, ty1 = INT32_MIN;
+        for (auto& tile: order) {
+            tx0 = std::min(tx0, tile->tx);
+            ty0 = std::min(ty0, tile->ty);
+            tx1 = std::max(tx1, tile->tx);
+            ty1 = std::max(ty1, tile->ty);
+        }
+        width = (tx1 - tx0 + 1) * TileSize;
+        height = (ty1 - ty0 + 1) * TileSize;
+        originX = tx0 * TileSize;
+        originY = ty0 * TileSize;
+        out.assign(size_t(width) * size_t(height), 0);
+        for (auto& tile: order) {
+            auto x0 = size_t(tile->tx - tx0) * TileSize;
+            auto y0 = size_t(tile->ty - ty0) * TileSize;
+            for (size_t row = 0; row < TileSize; ++row) {
+                std::copy_n(tile->cells + row * TileSize, TileSize, out.data() + (y0 + row) * size_t(width) + x0);
+            }
+        }
+        return true;
+    }
+
+    void Clear() {
+        std::lock_guard lock(mtx);
+        for (auto& tile: order) {
+            std::fill(std::begin(tile->cells), std::end(tile->cells), Cell{});
+        }
+    }
+
+    double Resolution() const noexcept {
+        return params.resolution;
+    }
+
+    uint64_t Hits() const {
+        std::lock_guard lock(mtx);
+        return hits;
+    }
+
+private:
+    struct Ray {
+        int32_t x1, y1;
+        bool hit;
+    };
+
+    static Cell toCell(double logOdds) {
+        return Cell(std::clamp(std::lround(logOdds * 1000), long(INT16_MIN), long(INT16_MAX)));
+    }
+
+    static int32_t floorDiv(int32_t v) noexcept {
+        return v >= 0 ? v >> TileBits : -((-v + TileSize - 1) >> TileBits);
+    }
+
+    static uint64_t key(int32_t tx, int32_t ty) noexcept {
+        return uint64_t(uint32_t(tx)) << 32 | uint32_t(ty);
+    }
+
+    // Branch-free transform into world cells first, so it vectorizes
+    void endpoints(Scan const& scan, double sx, double sy, double sth) {
+        auto n = scan.size();
+        xs.resize(n);
+        ys.resize(n);
+        auto inv = float(1 / params.resolution);
+        auto c = float(std::cos(sth));
+        auto s = float(std::sin(sth));
+        auto maxr = float(params.maxRange);
+        auto ox = float(sx) * inv;
+        auto oy = float(sy) * inv;
+        for (size_t i = 0; i < n; ++i) {
+            auto r = std::min(scan[i].range, maxr);
+            auto k = scan[i].range > 0 ? r / scan[i].range * inv : 0.f;
+            xs[i] = ox + (c * scan[i].x - s * scan[i].y) * k;
+            ys[i] = oy + (s * scan[i].x + c * scan[i].y) * k;
+        }
+        x0 = int32_t(std::floor(ox));
+        y0 = int32_t(std::floor(oy));
+        rays.clear();
+        angles.clear();
+        for (size_t i = 0; i < n; ++i) {
+            if (scan[i].range < params.minRange) {
+                continue;
+            }
+            rays.push_back({int32_t(std::floor(xs[i])), int32_t(std::floor(ys[i])), scan[i].range <= maxr});
+            angles.push_back(scan[i].relTheta);
+        }
+    }
+
+    // Every tile of the rays' bounding box, so casting never inserts
+    void allocate() {
+        auto tx0 = floorDiv(x0), tx1 = tx0, ty0 = floorDiv(y0), ty1 = ty0;
+        for (auto& ray: rays) {
+            auto tx = floorDiv(ray.x1);
+            auto ty = floorDiv(ray.y1);
+            tx0 = std::min(tx0, tx);
+            tx1 = std::max(tx1, tx);
+            ty0 = std::min(ty0, ty);
+            ty1 = std::max(ty1, ty);
+        }
+        for (auto ty = ty0; ty <= ty1; ++ty) {
+            for (auto tx = tx0; tx <= tx1; ++tx) {
+                auto& slot = tiles[key(tx, ty)];
+                if (!slot) {
+                    slot = std::make_unique<Tile>();
+                    slot->tx = tx;
+                    slot->ty = ty;
+                    std::fill(std::begin(slot->cells), std::end(slot->cells), Cell{});
+                    order.push_back(slot.get());
+                }
+            }
+        }
+    }
+
+    // Bresenham steps [from, to) of a ray, the last step is the endpoint
+    void trace(Ray const& ray, int32_t from, int32_t to) noexcept {
+        auto dx = std::abs(ray.x1 - x0), sx = x0 < ray.x1 ? 1 : -1;
+        auto dy = -std::abs(ray.y1 - y0), sy = y0 < ray.y1 ? 1 : -1;
+        auto steps = std::max(dx, -dy);
+        auto err = dx + dy;
+        auto x = x0, y = y0;
+        Tile* tile = nullptr;
+        for (int32_t k = 0; k <= steps && k < to; ++k) {
+            if (k >= from) {
+                auto tx = floorDiv(x), ty = floorDiv(y);
+                if (!tile || tile->tx != tx || tile->ty != ty) {
+                    tile = tiles.find(key(tx, ty))->second.get();
+                }
+                auto& cell = tile->cells[(y - ty * TileSize) * TileSize + (x - tx * TileSize)];
+                if (k == steps && ray.hit) {
+                    cell = Cell(std::min(cell + hit, int(hi)));
+                } else {
+                    cell = Cell(std::max(cell + miss, int(lo)));
+                }
+            }
+            auto e2 = 2 * err;
+            if (e2 >= dy) {
+                err += dy;
+                x += sx;
+            }
+            if (e2 <= dx) {
+                err += dx;
+                y += sy;
+            }
+        }
+    }
+
+    Params params;
+    std::shared_ptr<Reactor> pool;
+    std::shared_ptr<const PoseFn> source;
+    Pose fixed;
+    Cell hit, miss, lo, hi;
+    // Per scan scratch, reused
+    vector<float> xs;
+    vector<float> ys;
+    vector<float> angles;
+    vector<Ray> rays;
+    vector<size_t> bounds;
+    int32_t x0 = 0;
+    int32_t y0 = 0;
+    std::unordered_map<uint64_t, unique_ptr<Tile>> tiles;
+    vector<Tile*> order;
+    uint64_t hits = 0;
+    mutable std::mutex mtx;
+};
+
+}
@@ -0,0 +1,349 @@
+#pragma once
+#include "scan.hpp"
+#include "odom.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+namespace bang
+{
+
+// Point-to-line scan-to-scan matcher. The previous scan is indexed in a
+// uniform grid searched in rings around each query, stopping as soon as no
+// closer point can exist. Normals come from angular neighbours.
+// Buffers are reused between scans.
+struct Icp final : ScanSink {
+    struct Params {
+        // Correspondence gate, meters
+        double maxDist = 0.3;
+        // Grid cell, meters
+        double cell = 0.05;
+        double minRange = 0.05;
+        int maxIterations = 30;
+        // Stop once an update is smaller than this (meters / radians)
+        double epsilon = 1e-4;
+        size_t minMatches = 30;
+        // Match every n-th point of the current scan
+        size_t stride = 1;
+    };
+
+    // Motion of the sensor between the previous and the current scan,
+    // expressed in the previous scan's frame
+    struct Match {
+        double t{};
+        double dx{};
+        double dy{};
+        double dth{};
+        // Matched share of the points used, 0..1
+        double score{};
+        double rmse{};
+        double elapsedMs{};
+        int iterations{};
+        size_t matched{};
+        bool ok{};
+    };
+
+    Icp(Params params) : params(params) {
+        if (params.maxDist <= 0 || params.cell <= 0) {
+            throw Err("Icp: max_dist and cell must be positive");
+        }
+        if (!this->params.stride) {
+            this->params.stride = 1;
+        }
+    }
+
+    // Wheel odometry used as initial guess for every match
+    void AttachOdometry(std::shared_ptr<Odometry> target) {
+        std::atomic_store(&odom, std::move(target));
+    }
+
+    void Consume(Scan const& scan) override {
+        auto started = Scan::Now();
+        auto prior = odomDelta();
+        load(scan, cur);
+        Match res;
+        res.t = scan.t;
+        if (ref.size() && cur.size()) {
+            res = match(prior);
+            res.t = scan.t;
+        }
+        if (!res.ok) {
+            res.dx = prior.x;
+            res.dy = prior.y;
+            res.dth = prior.th;
+        }
+        std::swap(ref, cur);
+        index();
+        res.elapsedMs = (Scan::Now() - started) * 1000;
+        std::lock_guard lock(mtx);
+        auto c = std::cos(pose.th);
+        auto s = std::sin(pose.th);
+        pose.x += c * res.dx - s * res.dy;
+        pose.y += s * res.dx + c * res.dy;
+        pose.th = std::remainder(pose.th + res.dth, 2 * M_PI);
+        pose.t = scan.t;
+        last = res;
+        hits++;
+    }
+
+    Pose Current() const {
+        std::lock_guard lock(mtx);
+        return pose;
+    }
+
+    Match Last() const {
+        std::lock_guard lock(mtx);
+        return last;
+    }
+
+    void Reset(double x, double y, double th) {
+        std::lock_guard lock(mtx);
+        pose.x = x;
+        pose.y = y;
+        pose.th = th;
+    }
+
+    uint64_t Hits() const {
+        std::lock_guard lock(mtx);
+        return hits;
+    }
+
+private:
+    struct Pt {
+        float x, y;
+        float nx, ny;
+        bool normal;
+    };
+
+    void load(Scan const& scan, vector<Pt>& out) {
+        out.clear();
+        for (size_t i = 0; i < scan.size(); ++i) {
+            auto& n = scan[i];
+            if (n.range >= params.minRange) {
+                out.push_back({n.x, n.y, 0, 0, false});
+            }
+        }
+    }
+
+    // Grid over the reference scan (counting sort) and its normals
+    void index() {
+        auto gate = float(params.maxDist);
+        for (size_t i = 0; i < ref.size(); ++i) {
+            auto& p = ref[i];
+            auto& a = ref[i ? i - 1 : i];
+            auto& b = ref[i + 1 < ref.size() ? i + 1 : i];
+            bool na = std::hypot(a.x - p.x, a.y - p.y) < gate;
+            bool nb = std::hypot(b.x - p.x, b.y - p.y) < gate;
+            auto tx = (nb ? b.x : p.x) - (na ? a.x : p.x);
+            auto ty = (nb ? b.y : p.y) - (na ? a.y : p.y);
+            auto len = std::hypot(tx, ty);
+            p.normal = len > 1e-6f;
+            if (p.normal) {
+                p.nx = -ty / len;
+                p.ny = tx / len;
+            }
+        }
+        cell = float(params.cell);
+        if (ref.empty()) {
+            cols = rows = 0;
+            return;
+        }
+        float minx = ref[0].x, maxx = minx, miny = ref[0].y, maxy = miny;
+        for (auto& p: ref) {
+            minx = std::min(minx, p.x);
+            maxx = std::max(maxx, p.x);
+            miny = std::min(miny, p.y);
+            maxy = std::max(maxy, p.y);
+        }
+        // Keep the grid bounded for very long ranges
+        while ((maxx - minx) / cell > MaxCells || (maxy - miny) / cell > MaxCells) {
+            cell *= 2;
+        }
+        ox = minx;
+        oy = miny;
+        cols = size_t((maxx - minx) / cell) + 1;
+        rows = size_t((maxy - miny) / cell) + 1;
+        starts.assign(cols * rows + 1, 0);
+        for (auto& p: ref) {
+            starts[cellOf(p.x, p.y) + 1]++;
+        }
+        for (size_t i = 1; i < starts.size(); ++i) {
+            starts[i] += starts[i - 1];
+        }
+        items.resize(ref.size());
+        fill.assign(starts.begin(), starts.end() - 1);
+        for (uint32_t i = 0; i < ref.size(); ++i) {
+            items[fill[cellOf(ref[i].x, ref[i].y)]++] = i;
+        }
+    }
+
+    size_t cellOf(float x, float y) const noexcept {
+        return size_t((y - oy) / cell) * cols + size_t((x - ox) / cell);
+    }
+
+    // Nearest reference point with a normal, -1 if none within the gate
+    long nearest(double x, double y) const noexcept {
+        auto fx = (x - ox) / cell;
+        auto fy = (y - oy) / cell;
+        auto reach = long(std::ceil(params.maxDist / cell));
+        if (fx < -reach || fy < -reach || fx > double(cols + reach) || fy > double(rows + reach)) {
+            return -1;
+        }
+        long cx = long(std::floor(fx));
+        long cy = long(std::floor(fy));
+        long best = -1;
+        double bestD = params.maxDist * params.maxDist;
+        for (long r = 0; r <= reach; ++r) {
+            for (long gy = cy - r; gy <= cy + r; ++gy) {
+                if (gy < 0 || gy >= long(rows)) continue;
+                // Only the border of the ring is new
+                long step = (gy == cy - r || gy == cy + r) ? 1 : 2 * r;
+                for (long gx = cx - r; gx <= cx + r; gx += step ? step : 1) {
+                    if (gx < 0 || gx >= long(cols)) continue;
+                    auto c = size_t(gy) * cols + size_t(gx);
+                    for (auto k = starts[c]; k < starts[c + 1]; ++k) {
+                        auto& q = ref[items[k]];
+                        if (!q.normal) continue;
+                        auto d = (q.x - x) * (q.x - x) + (q.y - y) * (q.y - y);
+                        if (d < bestD) {
+                            bestD = d;
+                            best = long(items[k]);
+                        }
+                    }
+                }
+            }
+            // Anything in further rings is at least r cells away
+            auto bound = double(r) * cell;
+            if (best >= 0 && bestD <= bound * bound) {
+                break;
+            }
+        }
+        return best;
+    }
+
+    Match match(Pose guess) const {
+        Match res;
+        double tx = guess.x, ty = guess.y, th = guess.th;
+        auto huber = params.maxDist / 3;
+        size_t used = 0;
+        for (res.iterations = 1; res.iterations <= params.maxIterations; ++res.iterations) {
+            auto c = std::cos(th);
+            auto s = std::sin(th);
+            double h[9] = {}, g[3] = {};
+            double sq = 0;
+            size_t matched = 0;
+            used = 0;
+            for (size_t i = 0; i < cur.size(); i += params.stride) {
+                used++;
+                auto px = double(cur[i].x), py = double(cur[i].y);
+                auto qx = c * px - s * py + tx;
+                auto qy = s * px + c * py + ty;
+                auto j = nearest(qx, qy);
+                if (j < 0) continue;
+                auto& q = ref[size_t(j)];
+                auto r = q.nx * (qx - q.x) + q.ny * (qy - q.y);
+                double jac[3] = {q.nx, q.ny, q.nx * (-s * px - c * py) + q.ny * (c * px - s * py)};
+                auto w = std::abs(r) < huber ? 1. : huber / std::abs(r);
+                for (int a = 0; a < 3; ++a) {
+                    g[a] += w * jac[a] * r;
+                    for (int b = 0; b < 3; ++b) {
+                        h[a * 3 + b] += w * jac[a] * jac[b];
+                    }
+                }
+                sq += r * r;
+                matched++;
+            }
+            res.matched = matched;
+            res.rmse = matched ? std::sqrt(sq / double(matched)) : 0;
+            if (matched < params.minMatches) {
+                res.ok = false;
+                return res;
+            }
+            double d[3];
+            if (!solve(h, g, d)) {
+                res.ok = false;
+                return res;
+            }
+            tx -= d[0];
+            ty -= d[1];
+            th -= d[2];
+            if (std::abs(d[0]) + std::abs(d[1]) < params.epsilon && std::abs(d[2]) < params.epsilon) {
+                break;
+            }
+        }
+        res.iterations = std::min(res.iterations, params.maxIterations);
+        res.ok = true;
+        res.dx = tx;
+        res.dy = ty;
+        res.dth = th;
+        res.score = used ? double(res.matched) / double(used) : 0;
+        return res;
+    }
+
+    // h * x = g for symmetric 3x3 h, Cramer's rule
+    static bool solve(const double* h, const double* g, double* x) noexcept {
+        auto det = h[0] * (h[4] * h[8] - h[5] * h[7])
+                 - h[1] * (h[3] * h[8] - h[5] * h[6])
+                 + h[2] * (h[3] * h[7] - h[4] * h[6]);
+        if (std::abs(det) < 1e-12) {
+            return false;
+        }
+        for (int col = 0; col < 3; ++col) {
+            double m[9];
+            std::copy(h, h + 9, m);
+            for (int r = 0; r < 3; ++r) {
+                m[r * 3 + col] = g[r];
+            }
+            x[col] = (m[0] * (m[4] * m[8] - m[5] * m[7])
+                    - m[1] * (m[3] * m[8] - m[5] * m[6])
+                    + m[2] * (m[3] * m[7] - m[4] * m[6])) / det;
+        }
+        return true;
+    }
+
+    // Odometry motion since the previous scan, in the previous robot frame
+    Pose odomDelta() {
+        auto current = std::atomic_load(&odom);
+        if (!current) {
+            return {};
+        }
+        auto now = current->Current();
+        Pose res;
+        if (haveOdom) {
+            auto c = std::cos(lastOdom.th);
+            auto s = std::sin(lastOdom.th);
+            auto dx = now.x - lastOdom.x;
+            auto dy = now.y - lastOdom.y;
+            res.x = c * dx + s * dy;
+            res.y = -s * dx + c * dy;
+            res.th = std::remainder(now.th - lastOdom.th, 2 * M_PI);
+        }
+        haveOdom = true;
+        lastOdom = now;
+        return res;
+    }
+
+    static constexpr float MaxCells = 512;
+
+    Params params;
+    std::shared_ptr<Odometry> odom;
+    Pose lastOdom;
+    bool haveOdom = false;
+    vector<Pt> ref;
+    vector<Pt> cur;
+    float cell = 0;
+    float ox = 0;
+    float oy = 0;
+    size_t cols = 0;
+    size_t rows = 0;
+    vector<uint32_t> starts;
+    vector<uint32_t> fill;
+    vector<uint32_t> items;
+    Pose pose;
+    Match last;
+    uint64_t hits = 0;
+    mutable std::mutex mtx;
+};
+
+}
@@ -0,0 +1,359 @@
+#pragma once
+#include "scan.hpp"
+#include "odom.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+
+namespace bang
+{
+
+struct Reflector {
+    // Center, sensor frame
+    float x{};
+    float y{};
+    float range{};
+    // Sensor angle of the center, radians, clockwise as relTheta
+    float bearing{};
+    float width{};
+    float intensity{};
+    uint32_t count{};
+    // Index range in the scan, last inclusive
+    uint32_t first{};
+    uint32_t last{};
+    // Landmark index for the best candidate, -1 if unmatched
+    int32_t landmark = -1;
+};
+
+// Robot pose in the landmark map frame
+struct PoseCandidate {
+    double x{};
+    double y{};
+    double th{};
+    uint32_t inliers{};
+    double rmse{};
+};
+
+// Finds runs of high-intensity returns (retro-reflective tape) and fits their
+// centers by intensity-weighted bearing, which resolves well below the
+// angular step. Pose candidates come from pairs of reflectors whose distance
+// matches a pair of mapped landmarks; each is scored by the other reflectors
+// and refined by a closed-form rigid fit over its inliers.
+struct ReflectorLocator final : ScanSink {
+    struct Params {
+        // Intensity as reported in nodes, returns above are reflective
+        double minIntensity = 40;
+        double minRange = 0.05;
+        double maxRange = 12;
+        // Consecutive low or missing returns tolerated inside one reflector
+        size_t maxHoles = 1;
+        size_t minPoints = 2;
+        double minWidth = 0.01;
+        double maxWidth = 0.2;
+        // Added to the range of every center, for cylindrical reflectors
+        double radius = 0;
+        // Reflector-to-landmark association gate, meters
+        double gate = 0.15;
+        // Pair distance tolerance, meters
+        double pairTolerance = 0.05;
+        size_t minInliers = 2;
+        size_t maxCandidates = 8;
+        // Sensor pose in the robot frame
+        double mountX = 0;
+        double mountY = 0;
+        double mountTh = 0;
+    };
+
+    struct Landmark {
+        double x, y;
+    };
+
+    ReflectorLocator(Params params) : params(params) {}
+
+    void SetLandmarks(vector<Landmark> marks) {
+        auto map = std::make_shared<Map>();
+        map->marks = std::move(marks);
+        auto& all = map->marks;
+        for (uint32_t a = 0; a < all.size(); ++a) {
+            for (uint32_t b = a + 1; b < all.size(); ++b) {
+                map->pairs.push_back({std::hypot(all[a].x - all[b].x, all[a].y - all[b].y), a, b});
+            }
+        }
+        std::sort(map->pairs.begin(), map->pairs.end(), [](Pair const& l, Pair const& r){ return l.d < r.d; });
+        std::atomic_store(&landmarks, std::shared_ptr<const Map>(std::move(map)));
+    }
+
+    void Consume(Scan const& scan) override {
+        detect(scan);
+        candScratch.clear();
+        if (auto map = std::atomic_load(&landmarks); map && map->marks.size() >= 2) {
+            locate(*map);
+        }
+        std::lock_guard lock(mtx);
+        reflectors.swap(found);
+        candidates.swap(candScratch);
+        hits++;
+    }
+
+    vector<Reflector> Reflectors() const {
+        std::lock_guard lock(mtx);
+        return reflectors;
+    }
+
+    // Best first: most inliers, then lowest rmse
+    vector<PoseCandidate> Candidates() const {
+        std::lock_guard lock(mtx);
+        return candidates;
+    }
+
+    uint64_t Hits() const {
+        std::lock_guard lock(mtx);
+        return hits;
+    }
+
+private:
+    struct Pair {
+        double d;
+        uint32_t a, b;
+    };
+    struct Map {
+        vector<Landmark> marks;
+        vector<Pair> pairs;
+    };
+
+    void detect(Scan const& scan) {
+        found.clear();
+        auto n = scan.size();
+        size_t i = 0;
+        while (i < n) {
+            if (!bright(scan[i])) {
+                i++;
+                continue;
+            }
+            // Extend the run across short holes
+            size_t first = i, last = i, holes = 0;
+            for (auto k = i + 1; k < n && holes <= params.maxHoles; ++k) {
+                if (bright(scan[k]) && std::abs(scan[k].range - scan[last].range) < params.maxWidth) {
+                    last = k;
+                    holes = 0;
+                } else {
+                    holes++;
+                }
+            }
+            i = last + 1;
+            fit(scan, first, last);
+        }
+        // The first and the last run may be one reflector across the seam
+        if (found.size() > 1) {
+            auto& a = found.back();
+            auto& b = found.front();
+            if (b.first + (n - 1 - a.last) <= params.maxHoles && std::hypot(a.x - b.x, a.y - b.y) < params.maxWidth) {
+                auto wa = double(a.intensity) * a.count, wb = double(b.intensity) * b.count;
+                auto dth = std::remainder(double(a.bearing) - double(b.bearing), 2 * M_PI);
+                auto bearing = std::remainder(double(b.bearing) + dth * wa / (wa + wb), 2 * M_PI);
+                auto range = (double(a.range) * wa + double(b.range) * wb) / (wa + wb) - params.radius;
+                b.width = std::hypot(scan[a.first].x - scan[b.last].x, scan[a.first].y - scan[b.last].y);
+                b.intensity = float((wa + wb) / (a.count + b.count));
+                b.count += a.count;
+                b.first = a.first;
+                place(b, range, bearing);
+                found.pop_back();
+            }
+        }
+        found.erase(std::remove_if(found.begin(), found.end(), [&](Reflector const& r){
+            return r.count < params.minPoints || r.width < params.minWidth || r.width > params.maxWidth;
+        }), found.end());
+    }
+
+    bool bright(ParsedNode const& n) const noexcept {
+        return n.intensity >= params.minIntensity && n.range >= params.minRange && n.range <= params.maxRange;
+    }
+
+    // Intensity-weighted bearing, relative to the first return to stay
+    // continuous across 0/2pi
+    void fit(Scan const& scan, size_t first, size_t last) {
+        double w = 0, sth = 0, sr = 0;
+        uint32_t count = 0;
+        auto base = double(scan[first].relTheta);
+        for (auto k = first; k <= last; ++k) {
+            auto& n = scan[k];
+            if (!bright(n)) {
+                continue;
+            }
+            auto wk = double(n.intensity);
+            w += wk;
+            sth += wk * std::remainder(double(n.relTheta) - base, 2 * M_PI);
+            sr += wk * n.range;
+            count++;
+        }
+        if (w <= 0) {
+            return;
+        }
+        Reflector r;
+        r.count = count;
+        r.first = uint32_t(first);
+        r.last = uint32_t(last);
+        r.intensity = float(w / count);
+        r.width = std::hypot(scan[first].x - scan[last].x, scan[first].y - scan[last].y);
+        place(r, sr / w, std::remainder(base + sth / w, 2 * M_PI));
+        found.push_back(r);
+    }
+
+    void place(Reflector& r, double range, double bearing) const noexcept {
+        r.range = float(range + params.radius);
+        r.bearing = float(bearing);
+        r.x = float(r.range * std::cos(bearing));
+        r.y = float(-r.range * std::sin(bearing));
+    }
+
+    // Reflectors in the robot frame
+    void toRobot() {
+        auto c = std::cos(params.mountTh), s = std::sin(params.mountTh);
+        pts.resize(found.size());
+        for (size_t i = 0; i < found.size(); ++i) {
+            pts[i] = {params.mountX + c * found[i].x - s * found[i].y,
+                      params.mountY + s * found[i].x + c * found[i].y};
+        }
+    }
+
+    void locate(Map const& map) {
+        toRobot();
+        auto tol = params.pairTolerance;
+        for (size_t i = 0; i < pts.size(); ++i) {
+            for (size_t j = i + 1; j < pts.size(); ++j) {
+                auto d = std::hypot(pts[i].x - pts[j].x, pts[i].y - pts[j].y);
+                auto it = std::lower_bound(map.pairs.begin(), map.pairs.end(), d - tol,
+                                           [](Pair const& p, double v){ return p.d < v; });
+                for (; it != map.pairs.end() && it->d <= d + tol; ++it) {
+                    // Either orientation of the landmark pair
+                    hypothesis(map, i, j, it->a, it->b);
+                    hypothesis(map, i, j, it->b, it->a);
+                }
+            }
+        }
+        std::sort(candScratch.begin(), candScratch.end(), [](PoseCandidate const& a, PoseCandidate const& b){
+            return a.inliers != b.inliers ? a.inliers > b.inliers : a.rmse < b.rmse;
+        });
+        if (candScratch.size() > params.maxCandidates) {
+            candScratch.resize(params.maxCandidates);
+        }
+        // Label reflectors with the best candidate's associations
+        if (candScratch.size()) {
+            associate(map, candScratch[0]);
+            for (size_t i = 0; i < found.size(); ++i) {
+                found[i].landmark = assoc[i];
+            }
+        }
+    }
+
+    void hypothesis(Map const& map, size_t i, size_t j, uint32_t a, uint32_t b) {
+        PoseCandidate cand;
+        src.assign({pts[i], pts[j]});
+        dst.assign({map.marks[a], map.marks[b]});
+        rigid(cand);
+        // Score with every reflector, refit on the inliers
+        for (int pass = 0; pass < 2; ++pass) {
+            associate(map, cand);
+            src.clear();
+            dst.clear();
+            for (size_t k = 0; k < pts.size(); ++k) {
+                if (assoc[k] >= 0) {
+                    src.push_back(pts[k]);
+                    dst.push_back(map.marks[size_t(assoc[k])]);
+                }
+            }
+            if (src.size() < params.minInliers || src.size() < 2) {
+                return;
+            }
+            rigid(cand);
+        }
+        cand.inliers = uint32_t(src.size());
+        double sq = 0;
+        auto c = std::cos(cand.th), s = std::sin(cand.th);
+        for (size_t k = 0; k < src.size(); ++k) {
+            auto ex = cand.x + c * src[k].x - s * src[k].y - dst[k].x;
+            auto ey = cand.y + s * src[k].x + c * src[k].y - dst[k].y;
+            sq += ex * ex + ey * ey;
+        }
+        cand.rmse = std::sqrt(sq / double(src.size()));
+        // Pairs of one pose agree; keep the better
+        for (auto& other: candScratch) {
+            if (std::hypot(other.x - cand.x, other.y - cand.y) < params.gate
+                && std::abs(std::remainder(other.th - cand.th, 2 * M_PI)) < params.gate) {
+                if (cand.inliers > other.inliers || (cand.inliers == other.inliers && cand.rmse < other.rmse)) {
+                    other = cand;
+                }
+                return;
+            }
+        }
+        candScratch.push_back(cand);
+    }
+
+    // Nearest landmark within the gate for every reflector, one-to-one
+    void associate(Map const& map, PoseCandidate const& cand) {
+        auto c = std::cos(cand.th), s = std::sin(cand.th);
+        auto gate2 = params.gate * params.gate;
+        assoc.assign(pts.size(), -1);
+        taken.assign(map.marks.size(), false);
+        for (size_t k = 0; k < pts.size(); ++k) {
+            auto wx = cand.x + c * pts[k].x - s * pts[k].y;
+            auto wy = cand.y + s * pts[k].x + c * pts[k].y;
+            auto best = gate2;
+            for (size_t m = 0; m < map.marks.size(); ++m) {
+                auto d = (map.marks[m].x - wx) * (map.marks[m].x - wx) + (map.marks[m].y - wy) * (map.marks[m].y - wy);
+                if (d < best && !taken[m]) {
+                    best = d;
+                    assoc[k] = int32_t(m);
+                }
+            }
+            if (assoc[k] >= 0) {
+                taken[size_t(assoc[k])] = true;
+            }
+        }
+    }
+
+    // Least squares rotation and translation taking src onto dst
+    void rigid(PoseCandidate& cand) const noexcept {
+        double sx = 0, sy = 0, dx = 0, dy = 0;
+        auto n = double(src.size());
+        for (size_t k = 0; k < src.size(); ++k) {
+            sx += src[k].x;
+            sy += src[k].y;
+            dx += dst[k].x;
+            dy += dst[k].y;
+        }
+        sx /= n;
+        sy /= n;
+        dx /= n;
+        dy /= n;
+        double cross = 0, dot = 0;
+        for (size_t k = 0; k < src.size(); ++k) {
+            auto px = src[k].x - sx, py = src[k].y - sy;
+            auto qx = dst[k].x - dx, qy = dst[k].y - dy;
+            cross += px * qy - py * qx;
+            dot += px * qx + py * qy;
+        }
+        cand.th = std::atan2(cross, dot);
+        auto c = std::cos(cand.th), s = std::sin(cand.th);
+        cand.x = dx - (c * sx - s * sy);
+        cand.y = dy - (s * sx + c * sy);
+    }
+
+    Params params;
+    std::shared_ptr<const Map> landmarks;
+    // Per scan scratch, reused
+    vector<Reflector> found;
+    vector<Landmark> pts;
+    vector<Landmark> src;
+    vector<Landmark> dst;
+    vector<int32_t> assoc;
+    vector<bool> taken;
+    vector<PoseCandidate> candScratch;
+    vector<Reflector> reflectors;
+    vector<PoseCandidate> candidates;
+    uint64_t hits = 0;
+    mutable std::mutex mtx;
+};
+
+}
@@ -0,0 +1,296 @@
+#pragma once
+#include "scan.hpp"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace bang
+{
+
+// Line in Hessian form: points p with p . (cos alpha, sin alpha) = r
+struct LineSegment {
+    float x0{}, y0{};
+    float x1{}, y1{};
+    float alpha{};
+    float r{};
+    // Covariance of (alpha, r) for the configured point noise
+    float varAlpha{};
+    float varR{};
+    float covAlphaR{};
+    uint32_t count{};
+    uint32_t first{};
+    uint32_t last{};
+};
+
+struct Corner {
+    float x{};
+    float y{};
+    // Angle between the two lines, 0..pi
+    float angle{};
+    // Indices into the segments of the same scan
+    uint32_t a{};
+    uint32_t b{};
+};
+
+// Split-and-merge over runs of adjacent returns of the angle-ordered scan,
+// total least squares fits, corners where consecutive segments meet.
+// Output and scratch vectors are reused: no allocations after warm-up.
+struct LineExtractor final : ScanSink {
+    struct Params {
+        double minRange = 0.05;
+        double maxRange = 12;
+        // Run breakpoint between consecutive returns, as in Segmenter
+        double gap = 0.1;
+        double gapRatio = 3;
+        // Split while a point is further than this from the chord
+        double splitDist = 0.03;
+        // Merge neighbours this close in (alpha, r)
+        double mergeAngle = 3 * M_PI / 180;
+        double mergeDist = 0.05;
+        size_t minPoints = 6;
+        double minLength = 0.15;
+        // Range noise, for covariances
+        double sigma = 0.01;
+        // Corner: endpoints closer than this, lines at least this far from parallel
+        double cornerDist = 0.15;
+        double cornerAngle = 30 * M_PI / 180;
+    };
+
+    LineExtractor(Params params) : params(params) {}
+
+    void Consume(Scan const& scan) override {
+        Extract(scan);
+        std::lock_guard lock(mtx);
+        lines.swap(segs);
+        corners.swap(cornerScratch);
+        hits++;
+    }
+
+    // Into the scratch buffers, exposed for benchmarks
+    void Extract(Scan const& scan) {
+        segs.clear();
+        cornerScratch.clear();
+        idx.clear();
+        for (uint32_t i = 0; i < scan.size(); ++i) {
+            auto& n = scan[i];
+            if (n.range >= params.minRange && n.range <= params.maxRange) {
+                idx.push_back(i);
+            }
+        }
+        // Start at a real break, so no run crosses the 0/2pi seam
+        for (size_t i = 1; i < idx.size(); ++i) {
+            if (!adjacent(scan[idx[i - 1]], scan[idx[i]])) {
+                std::rotate(idx.begin(), idx.begin() + long(i), idx.end());
+                break;
+            }
+        }
+        size_t begin = 0;
+        for (size_t i = 1; i <= idx.size(); ++i) {
+            if (i == idx.size() || !adjacent(scan[idx[i - 1]], scan[idx[i]])) {
+                run(scan, begin, i);
+                begin = i;
+            }
+        }
+        findCorners();
+    }
+
+    vector<LineSegment> Lines() const {
+        std::lock_guard lock(mtx);
+        return lines;
+    }
+
+    vector<Corner> Corners() const {
+        std::lock_guard lock(mtx);
+        return corners;
+    }
+
+    uint64_t Hits() const {
+        std::lock_guard lock(mtx);
+        return hits;
+    }
+
+    vector<LineSegment> const& LastLines() const noexcept {
+        return segs;
+    }
+
+private:
+    bool adjacent(ParsedNode const& a, ParsedNode const& b) const noexcept {
+        auto dth = std::abs(std::remainder(double(b.relTheta) - double(a.relTheta), 2 * M_PI));
+        auto limit = params.gap + params.gapRatio * std::min(a.range, b.range) * dth;
+        return std::hypot(a.x - b.x, a.y - b.y) <= limit;
+    }
+
+    // Split idx[begin, end) with an explicit stack, then merge in order
+    void run(Scan const& scan, size_t begin, size_t end) {
+        if (end - begin < params.minPoints) {
+            return;
+        }
+        auto mark = segs.size();
+        spans.resize(mark);
+        stack.clear();
+        stack.push_back({begin, end});
+        while (stack.size()) {
+            auto [b, e] = stack.back();
+            stack.pop_back();
+            if (e - b < params.minPoints) {
+                continue;
+            }
+            auto& p0 = scan[idx[b]];
+            auto& p1 = scan[idx[e - 1]];
+            auto dx = double(p1.x - p0.x), dy = double(p1.y - p0.y);
+            auto len = std::hypot(dx, dy);
+            size_t worst = b;
+            double worstD = 0;
+            if (len > 1e-6) {
+                for (auto k = b + 1; k + 1 < e; ++k) {
+                    auto& p = scan[idx[k]];
+                    auto d = std::abs(dx * (p0.y - p.y) - dy * (p0.x - p.x)) / len;
+                    if (d > worstD) {
+                        worstD = d;
+                        worst = k;
+                    }
+                }
+            }
+            if (worstD > params.splitDist) {
+                // Right half first, so segments come out in scan order
+                stack.push_back({worst, e});
+                stack.push_back({b, worst + 1});
+                continue;
+            }
+            LineSegment seg;
+            if (fit(scan, b, e, seg)) {
+                segs.push_back(seg);
+                spans.push_back({b, e});
+            }
+        }
+        // Merge collinear neighbours of this run
+        size_t out = mark;
+        for (auto i = mark; i < segs.size(); ++i) {
+            if (out > mark && mergeable(segs[out - 1], segs[i])) {
+                LineSegment joined;
+                if (fit(scan, spans[out - 1].b, spans[i].e, joined)) {
+                    segs[out - 1] = joined;
+                    spans[out - 1].e = spans[i].e;
+                    continue;
+                }
+            }
+            spans[out] = spans[i];
+            segs[out++] = segs[i];
+        }
+        segs.resize(out);
+        segs.erase(std::remove_if(segs.begin() + long(mark), segs.end(), [&](LineSegment const& s){
+            return std::hypot(s.x1 - s.x0, s.y1 - s.y0) < params.minLength;
+        }), segs.end());
+    }
+
+    bool mergeable(LineSegment const& a, LineSegment const& b) const noexcept {
+        auto dAlpha = std::abs(std::remainder(double(a.alpha) - double(b.alpha), 2 * M_PI));
+        return dAlpha < params.mergeAngle && std::abs(a.r - b.r) < params.mergeDist;
+    }
+
+    // Total least squares over idx[b, e)
+    bool fit(Scan const& scan, size_t b, size_t e, LineSegment& seg) const noexcept {
+        auto n = double(e - b);
+        double mx = 0, my = 0;
+        for (auto k = b; k < e; ++k) {
+            mx += scan[idx[k]].x;
+            my += scan[idx[k]].y;
+        }
+        mx /= n;
+        my /= n;
+        double sxx = 0, syy = 0, sxy = 0;
+        for (auto k = b; k < e; ++k) {
+            auto dx = scan[idx[k]].x - mx, dy = scan[idx[k]].y - my;
+            sxx += dx * dx;
+            syy += dy * dy;
+            sxy += dx * dy;
+        }
+        auto alpha = 0.5 * std::atan2(-2 * sxy, syy - sxx);
+        auto r = mx * std::cos(alpha) + my * std::sin(alpha);
+        if (r < 0) {
+            r = -r;
+            alpha += M_PI;
+        }
+        alpha = std::remainder(alpha, 2 * M_PI);
+        auto c = std::cos(alpha), s = std::sin(alpha);
+        // Along-line coordinates, for extent and covariance
+        double tmin = INFINITY, tmax = -INFINITY, spread = 0;
+        auto tm = -mx * s + my * c;
+        for (auto k = b; k < e; ++k) {
+            auto t = -scan[idx[k]].x * s + scan[idx[k]].y * c;
+            tmin = std::min(tmin, t);
+            tmax = std::max(tmax, t);
+            spread += (t - tm) * (t - tm);
+        }
+        if (spread <= 0) {
+            return false;
+        }
+        auto sigma2 = params.sigma * params.sigma;
+        seg.alpha = float(alpha);
+        seg.r = float(r);
+        seg.varAlpha = float(sigma2 / spread);
+        seg.varR = float(sigma2 / n + tm * tm * sigma2 / spread);
+        seg.covAlphaR = float(-tm * sigma2 / spread);
+        seg.x0 = float(r * c - tmin * s);
+        seg.y0 = float(r * s + tmin * c);
+        seg.x1 = float(r * c - tmax * s);
+        seg.y1 = float(r * s + tmax * c);
+        seg.count = uint32_t(e - b);
+        seg.first = idx[b];
+        seg.last = idx[e - 1];
+        // Keep scan order along the segment
+        auto& p0 = scan[seg.first];
+        if (std::hypot(p0.x - seg.x0, p0.y - seg.y0) > std::hypot(p0.x - seg.x1, p0.y - seg.y1)) {
+            std::swap(seg.x0, seg.x1);
+            std::swap(seg.y0, seg.y1);
+        }
+        return true;
+    }
+
+    void findCorners() {
+        if (segs.size() < 2) {
+            return;
+        }
+        for (size_t i = 0; i < segs.size(); ++i) {
+            auto j = (i + 1) % segs.size();
+            if (j == i || (j == 0 && segs.size() == 2)) {
+                continue;
+            }
+            auto& a = segs[i];
+            auto& b = segs[j];
+            if (std::hypot(a.x1 - b.x0, a.y1 - b.y0) > params.cornerDist) {
+                continue;
+            }
+            auto between = std::abs(std::remainder(double(a.alpha) - double(b.alpha), 2 * M_PI));
+            auto angle = std::min(between, M_PI - between);
+            if (angle < params.cornerAngle) {
+                continue;
+            }
+            auto det = std::sin(double(b.alpha) - double(a.alpha));
+            if (std::abs(det) < 1e-9) {
+                continue;
+            }
+            auto x = (a.r * std::sin(double(b.alpha)) - b.r * std::sin(double(a.alpha))) / det;
+            auto y = (b.r * std::cos(double(a.alpha)) - a.r * std::cos(double(b.alpha))) / det;
+            cornerScratch.push_back({float(x), float(y), float(M_PI - between), uint32_t(i), uint32_t(j)});
+        }
+    }
+
+    struct Range {
+        size_t b, e;
+    };
+
+    Params params;
+    vector<uint32_t> idx;
+    vector<Range> stack;
+    // Positions in idx of segs of the current run
+    vector<Range> spans;
+    vector<LineSegment> segs;
+    vector<Corner> cornerScratch;
+    vector<LineSegment> lines;
+    vector<Corner> corners;
+    uint64_t hits = 0;
+    mutable std::mutex mtx;
+};
+
+}
@@ -0,0 +1,469 @@
+#pragma once
+#include "scan.hpp"
+#include "odom.hpp"
+#include "reactor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <unordered_set>
+
+namespace bang
+{
+
+// Monte Carlo localization against a known map. Beams are scored against a
+// precomputed likelihood field (log of the beam model over the map's
+// euclidean distance transform), so a particle costs one lookup per beam.
+// Particles are scored in parallel chunks on a reactor, the particle count
+// adapts with KLD-sampling. Motion comes from odometry deltas via Predict().
+struct Mcl final : ScanSink {
+    struct Params {
+        size_t minParticles = 100;
+        size_t maxParticles = 5000;
+        // Beams used per scan, evenly spaced by index
+        size_t beams = 60;
+        double minRange = 0.05;
+        double maxRange = 12;
+        // Likelihood field model
+        double sigmaHit = 0.2;
+        double zHit = 0.95;
+        double zRand = 0.05;
+        // Odometry motion model noise (rot from rot, rot from trans,
+        // trans from trans, trans from rot)
+        double alpha1 = 0.2;
+        double alpha2 = 0.2;
+        double alpha3 = 0.2;
+        double alpha4 = 0.2;
+        // Skip scans until moved this much since the last update
+        double updateMinDist = 0.05;
+        double updateMinAngle = 0.05;
+        // KLD-sampling: error bound, upper standard normal quantile, bins
+        double kldErr = 0.05;
+        double kldZ = 2.33;
+        double binXY = 0.2;
+        double binTh = 10 * M_PI / 180;
+        // Sensor pose in the robot frame
+        double mountX = 0;
+        double mountY = 0;
+        double mountTh = 0;
+    };
+
+    struct Particle {
+        double x;
+        double y;
+        double th;
+        double w;
+    };
+
+    Mcl(Params params, std::shared_ptr<Reactor> pool = nullptr, unsigned seed = std::random_device{}()) :
+        params(params),
+        pool(std::move(pool)),
+        rng(seed)
+    {
+        if (!params.minParticles || params.minParticles > params.maxParticles) {
+            throw Err("Mcl: need 0 < min_particles <= max_particles");
+        }
+        if (params.sigmaHit <= 0 || params.maxRange <= 0) {
+            throw Err("Mcl: sigma_hit and max_range must be positive");
+        }
+    }
+
+    // occupied[y * width + x] != 0 marks obstacles, cell (0, 0) is at (x0, y0)
+    void SetMap(const uint8_t* occupied, size_t width, size_t height, double resolution, double x0, double y0) {
+        if (!width || !height || resolution <= 0) {
+            throw Err("Mcl: empty map");
+        }
+        auto n = width * height;
+        vector<float> dist(n);
+        distanceTransform(occupied, width, height, dist);
+        vector<float> field(n + 1);
+        auto rand = params.zRand / params.maxRange;
+        auto denom = 2 * params.sigmaHit * params.sigmaHit;
+        for (size_t i = 0; i < n; ++i) {
+            auto d = double(dist[i]) * resolution;
+            field[i] = float(std::log(params.zHit * std::exp(-d * d / denom) + rand));
+        }
+        // Sentinel for beams outside of the map
+        field[n] = float(std::log(rand));
+        vector<uint32_t> cells;
+        for (size_t i = 0; i < n; ++i) {
+            if (!occupied[i]) {
+                cells.push_back(uint32_t(i));
+            }
+        }
+        std::lock_guard lock(mtx);
+        logp = std::move(field);
+        free = std::move(cells);
+        mapW = width;
+        mapH = height;
+        mapRes = resolution;
+        mapX = x0;
+        mapY = y0;
+    }
+
+    // Gaussian around a pose
+    void Reset(double x, double y, double th, double sx, double sy, double sth) {
+        std::lock_guard lock(mtx);
+        std::normal_distribution<double> nx(x, sx), ny(y, sy), nth(th, sth);
+        particles.resize(params.maxParticles);
+        for (auto& p: particles) {
+            p = {nx(rng), ny(rng), std::remainder(nth(rng), 2 * M_PI), 1. / double(particles.size())};
+        }
+        moved = true;
+        estimate();
+    }
+
+    // Uniform over free cells
+    void ResetGlobal() {
+        std::lock_guard lock(mtx);
+        if (free.empty()) {
+            throw Err("Mcl: no map or no free cells");
+        }
+        std::uniform_int_distribution<size_t> cell(0, free.size() - 1);
+        std::uniform_real_distribution<double> jitter(0, 1), angle(-M_PI, M_PI);
+        particles.resize(params.maxParticles);
+        for (auto& p: particles) {
+            auto c = free[cell(rng)];
+            p.x = mapX + (double(c % mapW) + jitter(rng)) * mapRes;
+            p.y = mapY + (double(c / mapW) + jitter(rng)) * mapRes;
+            p.th = angle(rng);
+            p.w = 1. / double(particles.size());
+        }
+        moved = true;
+        estimate();
+    }
+
+    // Odometry delta in the robot frame of the previous pose
+    void Predict(double dx, double dy, double dth) {
+        std::lock_guard lock(mtx);
+        auto trans = std::hypot(dx, dy);
+        // Backwards motion: rotate towards the opposite direction
+        auto rot1 = trans < 1e-4 ? 0. : std::atan2(dy, dx);
+        if (std::abs(rot1) > M_PI / 2) {
+            rot1 = std::remainder(rot1 + M_PI, 2 * M_PI);
+            trans = -trans;
+        }
+        auto rot2 = std::remainder(dth - rot1, 2 * M_PI);
+        auto& a = params;
+        auto sdRot1 = std::sqrt(a.alpha1 * rot1 * rot1 + a.alpha2 * trans * trans);
+        auto sdTrans = std::sqrt(a.alpha3 * trans * trans + a.alpha4 * (rot1 * rot1 + rot2 * rot2));
+        auto sdRot2 = std::sqrt(a.alpha1 * rot2 * rot2 + a.alpha2 * trans * trans);
+        std::normal_distribution<double> unit(0, 1);
+        for (auto& p: particles) {
+            auto r1 = rot1 + sdRot1 * unit(rng);
+            auto t = trans + sdTrans * unit(rng);
+            auto r2 = rot2 + sdRot2 * unit(rng);
+            p.x += t * std::cos(p.th + r1);
+            p.y += t * std::sin(p.th + r1);
+            p.th = std::remainder(p.th + r1 + r2, 2 * M_PI);
+        }
+        travelled += std::abs(trans);
+        turned += std::abs(dth);
+        if (travelled >= params.updateMinDist || turned >= params.updateMinAngle) {
+            moved = true;
+        }
+        estimate();
+    }
+
+    void Consume(Scan const& scan) override {
+        std::lock_guard lock(mtx);
+        if (particles.empty() || logp.empty() || !moved) {
+            return;
+        }
+        beams(scan);
+        if (bx.size() < 3) {
+            return;
+        }
+        score();
+        normalize();
+        if (Neff() < double(particles.size()) / 2) {
+            resample();
+        }
+        estimate();
+        moved = false;
+        travelled = 0;
+        turned = 0;
+        hits++;
+    }
+
+    Pose Current() const {
+        std::lock_guard lock(mtx);
+        return mean;
+    }
+
+    Odometry::Cov Covariance() const {
+        std::lock_guard lock(mtx);
+        return cov;
+    }
+
+    vector<Particle> Particles() const {
+        std::lock_guard lock(mtx);
+        return particles;
+    }
+
+    double EffectiveSize() const {
+        std::lock_guard lock(mtx);
+        return Neff();
+    }
+
+    uint64_t Hits() const {
+        std::lock_guard lock(mtx);
+        return hits;
+    }
+
+private:
+    double Neff() const noexcept {
+        double sq = 0;
+        for (auto& p: particles) {
+            sq += p.w * p.w;
+        }
+        return sq > 0 ? 1 / sq : 0;
+    }
+
+    // Felzenszwalb-Huttenlocher squared EDT along columns then rows, in cells
+    static void distanceTransform(const uint8_t* occupied, size_t w, size_t h, vector<float>& out) {
+        constexpr double inf = 1e20;
+        auto n = std::max(w, h);
+        vector<double> f(n), d(n), z(n + 1);
+        vector<size_t> v(n);
+        auto pass = [&](size_t len) {
+            auto parabola = [&](size_t q, size_t p) {
+                return ((f[q] + double(q * q)) - (f[p] + double(p * p))) / (2. * double(q) - 2. * double(p));
+            };
+            size_t k = 0;
+            v[0] = 0;
+            z[0] = -inf;
+            z[1] = inf;
+            for (size_t q = 1; q < len; ++q) {
+                auto s = parabola(q, v[k]);
+                while (s <= z[k]) {
+                    k--;
+                    s = parabola(q, v[k]);
+                }
+                k++;
+                v[k] = q;
+                z[k] = s;
+                z[k + 1] = inf;
+            }
+            k = 0;
+            for (size_t q = 0; q < len; ++q) {
+                while (z[k + 1] < double(q)) {
+                    k++;
+                }
+                auto diff = double(q) - double(v[k]);
+                d[q] = diff * diff + f[v[k]];
+            }
+        };
+        out.resize(w * h);
+        for (size_t x = 0; x < w; ++x) {
+            for (size_t y = 0; y < h; ++y) {
+                f[y] = occupied[y * w + x] ? 0 : inf;
+            }
+            pass(h);
+            for (size_t y = 0; y < h; ++y) {
+                out[y * w + x] = float(std::min(d[y], inf));
+            }
+        }
+        for (size_t y = 0; y < h; ++y) {
+            for (size_t x = 0; x < w; ++x) {
+                f[x] = double(out[y * w + x]);
+            }
+            pass(w);
+            for (size_t x = 0; x < w; ++x) {
+                out[y * w + x] = float(std::sqrt(d[x]));
+            }
+        }
+    }
+
+    void beams(Scan const& scan) {
+        bx.clear();
+        by.clear();
+        auto step = std::max<size_t>(1, scan.size() / std::max<size_t>(1, params.beams));
+        for (size_t i = 0; i < scan.size(); i += step) {
+            auto& n = scan[i];
+            if (n.range < params.minRange || n.range > params.maxRange) {
+                continue;
+            }
+            bx.push_back(n.x);
+            by.push_back(n.y);
+        }
+    }
+
+    // Sum of beam log-likelihoods. Beams go in blocks: cell indices first,
+    // clamped to a sentinel cell instead of branching, so that loop has no
+    // control flow and vectorizes at -O3 (check with -fopt-info-vec-optimized);
+    // then scalar lookups, the float sum keeps its order without -ffast-math.
+    double scoreOne(Particle const& p) const noexcept {
+        constexpr size_t Block = 64;
+        auto th = p.th + params.mountTh;
+        auto rc = std::cos(p.th), rs = std::sin(p.th);
+        auto inv = float(1 / mapRes);
+        auto sx = float((p.x + rc * params.mountX - rs * params.mountY - mapX) / mapRes);
+        auto sy = float((p.y + rs * params.mountX + rc * params.mountY - mapY) / mapRes);
+        auto c = float(std::cos(th)) * inv;
+        auto s = float(std::sin(th)) * inv;
+        auto w = float(mapW), h = float(mapH);
+        auto sentinel = int32_t(mapW * mapH);
+        auto stride = int32_t(mapW);
+        auto field = logp.data();
+        float sum = 0;
+        int32_t idx[Block];
+        for (size_t from = 0; from < bx.size(); from += Block) {
+            auto count = std::min(Block, bx.size() - from);
+            auto x = bx.data() + from;
+            auto y = by.data() + from;
+            for (size_t b = 0; b < count; ++b) {
+                auto fx = sx + c * x[b] - s * y[b];
+                auto fy = sy + s * x[b] + c * y[b];
+                bool in = (fx >= 0) & (fy >= 0) & (fx < w) & (fy < h);
+                idx[b] = in ? int32_t(fy) * stride + int32_t(fx) : sentinel;
+            }
+            for (size_t b = 0; b < count; ++b) {
+                sum += field[idx[b]];
+            }
+        }
+        return double(sum);
+    }
+
+    void score() {
+        constexpr size_t Chunk = 64;
+        loglik.resize(particles.size());
+        auto chunks = (particles.size() + Chunk - 1) / Chunk;
+        auto run = [&](size_t i) {
+            auto end = std::min(particles.size(), (i + 1) * Chunk);
+            for (auto k = i * Chunk; k < end; ++k) {
+                loglik[k] = scoreOne(particles[k]);
+            }
+        };
+        if (pool) {
+            pool->ParallelFor(chunks, run);
+        } else {
+            for (size_t i = 0; i < chunks; ++i) {
+                run(i);
+            }
+        }
+    }
+
+    // Weights times scan likelihoods, shifted by the best log-likelihood
+    void normalize() {
+        auto best = -std::numeric_limits<double>::infinity();
+        for (auto ll: loglik) {
+            best = std::max(best, ll);
+        }
+        double total = 0;
+        for (size_t i = 0; i < particles.size(); ++i) {
+            auto& p = particles[i];
+            p.w *= std::exp(loglik[i] - best);
+            total += p.w;
+        }
+        if (total <= 0) {
+            for (auto& p: particles) {
+                p.w = 1;
+            }
+            total = double(particles.size());
+        }
+        for (auto& p: particles) {
+            p.w /= total;
+        }
+    }
+
+    uint64_t bin(Particle const& p) const noexcept {
+        auto bx = int64_t(std::floor(p.x / params.binXY)) & 0x1FFFFF;
+        auto by = int64_t(std::floor(p.y / params.binXY)) & 0x1FFFFF;
+        auto bth = int64_t(std::floor(p.th / params.binTh)) & 0x1FFFFF;
+        return uint64_t(bx) << 42 | uint64_t(by) << 21 | uint64_t(bth);
+    }
+
+    // KLD bound on particles needed for k occupied bins
+    size_t kldLimit(size_t k) const noexcept {
+        if (k <= 1) {
+            return params.minParticles;
+        }
+        auto a = 2. / (9. * double(k - 1));
+        auto b = 1 - a + std::sqrt(a) * params.kldZ;
+        auto n = double(k - 1) / (2 * params.kldErr) * b * b * b;
+        return std::clamp(size_t(std::ceil(n)), params.minParticles, params.maxParticles);
+    }
+
+    void resample() {
+        cumulative.resize(particles.size());
+        double acc = 0;
+        for (size_t i = 0; i < particles.size(); ++i) {
+            acc += particles[i].w;
+            cumulative[i] = acc;
+        }
+        std::uniform_real_distribution<double> pick(0, acc);
+        next.clear();
+        bins.clear();
+        size_t limit = params.minParticles;
+        while (next.size() < limit && next.size() < params.maxParticles) {
+            auto it = std::lower_bound(cumulative.begin(), cumulative.end(), pick(rng));
+            auto i = std::min(size_t(it - cumulative.begin()), particles.size() - 1);
+            next.push_back(particles[i]);
+            if (bins.insert(bin(particles[i])).second) {
+                limit = kldLimit(bins.size());
+            }
+        }
+        for (auto& p: next) {
+            p.w = 1. / double(next.size());
+        }
+        particles.swap(next);
+    }
+
+    void estimate() {
+        double x = 0, y = 0, c = 0, s = 0, total = 0;
+        for (auto& p: particles) {
+            x += p.w * p.x;
+            y += p.w * p.y;
+            c += p.w * std::cos(p.th);
+            s += p.w * std::sin(p.th);
+            total += p.w;
+        }
+        if (total <= 0) {
+            return;
+        }
+        mean.x = x / total;
+        mean.y = y / total;
+        mean.th = std::atan2(s, c);
+        mean.t = Scan::Now();
+        cov = {};
+        for (auto& p: particles) {
+            double d[3] = {p.x - mean.x, p.y - mean.y, std::remainder(p.th - mean.th, 2 * M_PI)};
+            for (int r = 0; r < 3; ++r) {
+                for (int col = 0; col < 3; ++col) {
+                    cov[r * 3 + col] += p.w / total * d[r] * d[col];
+                }
+            }
+        }
+    }
+
+    Params params;
+    std::shared_ptr<Reactor> pool;
+    std::mt19937 rng;
+    // Likelihood field, last cell is the outside-of-map sentinel
+    vector<float> logp;
+    vector<uint32_t> free;
+    size_t mapW = 0;
+    size_t mapH = 0;
+    double mapRes = 1;
+    double mapX = 0;
+    double mapY = 0;
+    vector<Particle> particles;
+    // Scratch, reused between scans
+    vector<float> bx;
+    vector<float> by;
+    vector<double> loglik;
+    vector<double> cumulative;
+    vector<Particle> next;
+    std::unordered_set<uint64_t> bins;
+    bool moved = false;
+    double travelled = 0;
+    double turned = 0;
+    Pose mean;
+    Odometry::Cov cov{};
+    uint64_t hits = 0;
+    mutable std::mutex mtx;
+};
+
+}
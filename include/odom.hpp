@@ -0,0 +1,233 @@
+#pragma once
+#include "common.hpp"
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+
+namespace bang
+{
+
+struct Pose {
+    // Host steady_clock seconds, comparable with Scan::t
+    double t{};
+    double x{};
+    double y{};
+    double th{};
+};
+
+// Omni-wheel odometry, same geometry as script/odom.py with xCoeff/yCoeff
+// scaling the body frame, but integrated along the arc travelled during each
+// update instead of Euler steps.
+struct Odometry {
+    using Cov = std::array<double, 9>;
+
+    struct Params {
+        double baseRadius = 0.15;
+        double thetaCoeff = 1;
+        double xCoeff = 1;
+        double yCoeff = 1;
+        // Variance per meter travelled by each wheel, 0 disables covariance
+        double wheelNoise = 0;
+    };
+
+    Odometry(vector<double> anglesDegrees, Params params, size_t history = 256) :
+        params(params),
+        pending(anglesDegrees.size()),
+        ring(history ? history : 1)
+    {
+        if (anglesDegrees.empty()) {
+            throw Err("Odometry needs at least one motor");
+        }
+        for (auto deg: anglesDegrees) {
+            auto rads = deg * M_PI / 180.;
+            xs.push_back(std::cos(rads));
+            ys.push_back(std::sin(rads));
+        }
+    }
+
+    // MsgOdom: per motor deltas, integrated once the last motor reported
+    void HandleMotor(size_t num, double ddist) {
+        std::lock_guard lock(mtx);
+        if (num >= pending.size()) {
+            return;
+        }
+        pending[num] += ddist;
+        if (num == pending.size() - 1) {
+            integrate(pending.data(), hostTime());
+            std::fill(pending.begin(), pending.end(), 0.);
+        }
+    }
+
+    // MsgOdomAll: all deltas at once, sequenced by firmware. Stamped on the
+    // host clock at the first frame, then advanced by firmware micros so
+    // serial jitter stays out, never past arrival and re-anchored if it lags.
+    // seq or micros going backwards (firmware reset) or a repeated seq
+    // re-anchor without counting drops.
+    void HandleAll(const double* ddists, size_t count, uint32_t micros, uint16_t seq) {
+        std::lock_guard lock(mtx);
+        if (count != pending.size()) {
+            return;
+        }
+        auto now = hostTime();
+        auto step = uint16_t(seq - lastSeq);
+        auto elapsed = uint32_t(micros - lastMicros);
+        if (synced && step && step < 0x8000 && elapsed < 0x80000000u) {
+            dropped += step - 1u;
+            time = std::min(time + elapsed / 1e6, now);
+            if (now - time > MaxLag) {
+                time = now;
+            }
+        } else {
+            time = now;
+        }
+        synced = true;
+        lastSeq = seq;
+        lastMicros = micros;
+        integrate(ddists, time);
+    }
+
+    Pose Current() const {
+        std::lock_guard lock(mtx);
+        return pose;
+    }
+
+    Cov Covariance() const {
+        std::lock_guard lock(mtx);
+        return cov;
+    }
+
+    // Oldest first
+    vector<Pose> History() const {
+        std::lock_guard lock(mtx);
+        vector<Pose> res;
+        res.reserve(stored);
+        for (size_t i = 0; i < stored; ++i) {
+            res.push_back(ring[(head + ring.size() - stored + i) % ring.size()]);
+        }
+        return res;
+    }
+
+    void Reset(double x, double y, double th) {
+        std::lock_guard lock(mtx);
+        pose.x = x;
+        pose.y = y;
+        pose.th = th;
+        cov = {};
+        stored = 0;
+    }
+
+    uint64_t Dropped() const {
+        std::lock_guard lock(mtx);
+        return dropped;
+    }
+
+    uint64_t Hits() const {
+        std::lock_guard lock(mtx);
+        return hits;
+    }
+
+private:
+    // Seconds firmware stamps may trail the host clock before re-anchoring
+    static constexpr double MaxLag = 0.25;
+
+    // Same clock as Scan::Now()
+    static double hostTime() {
+        using namespace std::chrono;
+        return duration<double>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    void integrate(const double* ddists, double t) {
+        auto count = double(xs.size());
+        double bx = 0, by = 0, dth = 0;
+        for (size_t i = 0; i < xs.size(); ++i) {
+            bx += ddists[i] * xs[i];
+            by += ddists[i] * ys[i];
+            dth += ddists[i];
+        }
+        bx *= 2 / count * params.xCoeff;
+        by *= 2 / count * params.yCoeff;
+        dth *= params.thetaCoeff / count / params.baseRadius;
+        // Constant twist over the step: body delta = V(dth) * (bx, by)
+        double s = 1, c = 0;
+        if (std::abs(dth) > 1e-9) {
+            s = std::sin(dth) / dth;
+            c = (1 - std::cos(dth)) / dth;
+        }
+        auto lx = s * bx - c * by;
+        auto ly = c * bx + s * by;
+        auto cth = std::cos(pose.th);
+        auto sth = std::sin(pose.th);
+        auto dx = cth * lx - sth * ly;
+        auto dy = sth * lx + cth * ly;
+        if (params.wheelNoise > 0) {
+            propagate(ddists, dx, dy, cth, sth);
+        }
+        pose.x += dx;
+        pose.y += dy;
+        pose.th = std::remainder(pose.th + dth, 2 * M_PI);
+        pose.t = t;
+        ring[head] = pose;
+        head = (head + 1) % ring.size();
+        stored = std::min(stored + 1, ring.size());
+        hits++;
+    }
+
+    // P = F P F^T + G Q G^T, G taken to first order in dth
+    void propagate(const double* ddists, double dx, double dy, double cth, double sth) {
+        Cov f = {1, 0, -dy,
+                 0, 1, dx,
+                 0, 0, 1};
+        Cov next{};
+        mul(f, cov, next, false);
+        mul(next, f, cov, true);
+        auto count = double(xs.size());
+        for (size_t i = 0; i < xs.size(); ++i) {
+            auto q = params.wheelNoise * std::abs(ddists[i]);
+            auto lx = 2 / count * params.xCoeff * xs[i];
+            auto ly = 2 / count * params.yCoeff * ys[i];
+            double g[3] = {
+                cth * lx - sth * ly,
+                sth * lx + cth * ly,
+                params.thetaCoeff / count / params.baseRadius,
+            };
+            for (int r = 0; r < 3; ++r) {
+                for (int col = 0; col < 3; ++col) {
+                    cov[r * 3 + col] += g[r] * g[col] * q;
+                }
+            }
+        }
+    }
+
+    // out = a * (bT ? b^T : b)
+    static void mul(Cov const& a, Cov const& b, Cov& out, bool bT) {
+        for (int r = 0; r < 3; ++r) {
+            for (int col = 0; col < 3; ++col) {
+                double sum = 0;
+                for (int k = 0; k < 3; ++k) {
+                    sum += a[r * 3 + k] * (bT ? b[col * 3 + k] : b[k * 3 + col]);
+                }
+                out[r * 3 + col] = sum;
+            }
+        }
+    }
+
+    Params params;
+    vector<double> xs;
+    vector<double> ys;
+    vector<double> pending;
+    vector<Pose> ring;
+    size_t head = 0;
+    size_t stored = 0;
+    Pose pose;
+    Cov cov{};
+    double time = 0;
+    bool synced = false;
+    uint16_t lastSeq = 0;
+    uint32_t lastMicros = 0;
+    uint64_t dropped = 0;
+    uint64_t hits = 0;
+    mutable std::mutex mtx;
+};
+
+}
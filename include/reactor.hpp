@@ -0,0 +1,150 @@
+#pragma once
+#include "common.hpp"
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <cstring>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/post.hpp>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace bang
+{
+
+namespace asio = boost::asio;
+
+// io_context + thread pool, shared by all device channels of a process.
+// Devices attach by constructing their io objects on Reactor::io.
+struct Reactor {
+    asio::io_context io;
+    asio::executor_work_guard<asio::io_context::executor_type> guard;
+    vector<std::thread> threads;
+
+    Reactor(unsigned count = 1, vector<int> const& cpus = {}) :
+        io(int(count)),
+        guard(io.get_executor())
+    {
+        if (!count) {
+            throw Err("Reactor needs at least one thread");
+        }
+        try {
+            for (unsigned i = 0; i < count; ++i) {
+                threads.emplace_back(&Reactor::run, this);
+                if (cpus.size()) {
+                    pin(threads.back(), cpus[i % cpus.size()]);
+                }
+            }
+        } catch (...) {
+            stop();
+            throw;
+        }
+    }
+
+    Reactor(Reactor const&) = delete;
+
+    ~Reactor() {
+        stop();
+    }
+
+    size_t size() const noexcept {
+        return threads.size();
+    }
+
+    // fn(0) .. fn(count - 1) on the pool, blocks until all are done. The caller
+    // claims items as well, so this cannot deadlock when called from a reactor
+    // thread or while the pool is busy. First exception is rethrown.
+    template<typename F>
+    void ParallelFor(size_t count, F const& fn) {
+        if (!count) {
+            return;
+        }
+        struct State {
+            std::atomic<size_t> next{0};
+            size_t done = 0;
+            std::exception_ptr err;
+            std::mutex mtx;
+            std::condition_variable cv;
+        };
+        auto state = std::make_shared<State>();
+        // Helpers may start after we returned: they only touch fn while
+        // items are left, and there are none by then
+        auto work = [state, &fn, count]{
+            size_t finished = 0;
+            std::exception_ptr err;
+            for (size_t i; (i = state->next.fetch_add(1)) < count; ++finished) {
+                try {
+                    fn(i);
+                } catch (...) {
+                    if (!err) {
+                        err = std::current_exception();
+                    }
+                }
+            }
+            if (!finished) {
+                return;
+            }
+            std::lock_guard lock(state->mtx);
+            if (err && !state->err) {
+                state->err = err;
+            }
+            state->done += finished;
+            if (state->done == count) {
+                state->cv.notify_all();
+            }
+        };
+        auto helpers = std::min(count - 1, threads.size());
+        for (size_t i = 0; i < helpers; ++i) {
+            asio::post(io, work);
+        }
+        work();
+        std::unique_lock lock(state->mtx);
+        state->cv.wait(lock, [&]{ return state->done == count; });
+        if (state->err) {
+            std::rethrow_exception(state->err);
+        }
+    }
+
+private:
+    void stop() {
+        guard.reset();
+        io.stop();
+        for (auto& t: threads) {
+            if (t.joinable()) {
+                t.join();
+            }
+        }
+    }
+
+    void run() {
+        while (!io.stopped()) {
+            try {
+                io.run();
+            } catch (std::exception& e) {
+                fmt::print(stderr, "[!] Reactor: Unhandled: {}\n", e.what());
+            }
+        }
+    }
+
+    static void pin(std::thread& t, int cpu) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (auto err = pthread_setaffinity_np(t.native_handle(), sizeof(set), &set)) {
+            throw Err("Could not pin reactor thread to cpu {}: {}", cpu, strerror(err));
+        }
+#else
+        (void)t;
+        (void)cpu;
+#endif
+    }
+};
+
+}
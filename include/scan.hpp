@@ -0,0 +1,103 @@
+#pragma once
+#include "common.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+namespace bang
+{
+
+// Lidar return: polar as reported by the sensor, plus cartesian in a
+// right-handed sensor frame (x forward, y left). RPLidar angles grow
+// clockwise, hence y = -range * sin(relTheta). range == 0 marks no return.
+struct ParsedNode {
+    float range{};
+    float intensity{};
+    float relTheta{};
+    float x{};
+    float y{};
+};
+
+// One full revolution, ordered by ascending angle. Only valid for the
+// duration of ScanSink::Consume().
+struct Scan {
+    const ParsedNode* nodes = nullptr;
+    size_t count = 0;
+    // Host steady clock, seconds
+    double t = 0;
+    // Optional view of nodes without copying them: scan[i] is
+    // nodes[index[i]] and count is the length of index
+    const uint32_t* index = nullptr;
+
+    size_t size() const noexcept {
+        return count;
+    }
+    ParsedNode const& operator[](size_t i) const noexcept {
+        return index ? nodes[index[i]] : nodes[i];
+    }
+    // Position of scan[i] in nodes
+    uint32_t Index(size_t i) const noexcept {
+        return index ? index[i] : uint32_t(i);
+    }
+
+    static double Now() noexcept {
+        using namespace std::chrono;
+        return duration<double>(steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+// Native per-scan consumer, called on the lidar driver thread without the GIL
+struct ScanSink {
+    virtual void Consume(Scan const& scan) = 0;
+    virtual ~ScanSink() = default;
+};
+
+// Copy on write, so scans never wait for Attach/Detach
+struct SinkList {
+    void Attach(std::shared_ptr<ScanSink> sink) {
+        std::lock_guard lock(mtx);
+        auto next = copy();
+        next->push_back(std::move(sink));
+        std::atomic_store(&sinks, std::shared_ptr<const List>(std::move(next)));
+    }
+
+    void Detach(std::shared_ptr<ScanSink> const& sink) {
+        std::lock_guard lock(mtx);
+        auto next = copy();
+        next->erase(std::remove(next->begin(), next->end(), sink), next->end());
+        std::atomic_store(&sinks, std::shared_ptr<const List>(std::move(next)));
+    }
+
+    // Every sink runs, onError(std::exception&) gets what they throw
+    template<typename F>
+    void Run(Scan const& scan, F const& onError) const {
+        auto current = std::atomic_load(&sinks);
+        if (!current) {
+            return;
+        }
+        for (auto& sink: *current) {
+            try {
+                sink->Consume(scan);
+            } catch (std::exception& e) {
+                onError(e);
+            }
+        }
+    }
+
+private:
+    using List = vector<std::shared_ptr<ScanSink>>;
+
+    std::shared_ptr<List> copy() const {
+        auto next = std::make_shared<List>();
+        if (auto current = std::atomic_load(&sinks)) {
+            *next = *current;
+        }
+        return next;
+    }
+
+    std::shared_ptr<const List> sinks;
+    std::mutex mtx;
+};
+
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include "scan.hpp"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+namespace bang
+{
+
+// Bins every scan by angle (nearest return per bin) and keeps the last depth
+// binned scans in a ring. Each bin also keeps its window sorted, so a scan
+// costs a binary search to drop the oldest value, one to check for ghosts and
+// one to insert: O(bins * log depth), plus shifts of at most depth floats.
+// Ghosts are returns with no return within tolerance in the same or an
+// adjacent bin of any previous scan of the window.
+struct TemporalFilter final : ScanSink {
+    enum Mode {
+        Median,
+        // Closest return of the window, conservative for obstacle stops
+        Min,
+    };
+
+    struct Params {
+        size_t bins = 720;
+        size_t depth = 5;
+        Mode mode = Median;
+        // Bins with fewer returns in the window report 0
+        size_t minHits = 2;
+        double tolerance = 0.1;
+        double minRange = 0.05;
+        double maxRange = 12;
+    };
+
+    TemporalFilter(Params params) : params(params) {
+        if (!params.bins || !params.depth) {
+            throw Err("TemporalFilter: bins and depth must be positive");
+        }
+        ring.assign(params.bins * params.depth, 0);
+        sorted.assign(params.bins * params.depth, 0);
+        valid.assign(params.bins, 0);
+        binned.assign(params.bins, 0);
+        filtered.assign(params.bins, 0);
+        ghostScratch.assign(params.bins, 0);
+        outRanges = filtered;
+        outBinned = binned;
+        outGhosts = ghostScratch;
+    }
+
+    void Consume(Scan const& scan) override {
+        auto bins = params.bins;
+        auto depth = params.depth;
+        std::fill(binned.begin(), binned.end(), 0.f);
+        auto scale = float(bins / (2 * M_PI));
+        for (size_t i = 0; i < scan.size(); ++i) {
+            auto& n = scan[i];
+            if (n.range < params.minRange || n.range > params.maxRange) {
+                continue;
+            }
+            auto b = size_t(std::max(0.f, n.relTheta * scale)) % bins;
+            if (!binned[b] || n.range < binned[b]) {
+                binned[b] = n.range;
+            }
+        }
+        // Oldest scan leaves the window first, so ghosts are checked
+        // against the other depth - 1 scans only
+        for (size_t b = 0; b < bins; ++b) {
+            if (auto old = ring[b * depth + head]; old > 0) {
+                auto win = window(b);
+                auto it = std::lower_bound(win, win + valid[b], old);
+                std::copy(it + 1, win + valid[b], it);
+                valid[b]--;
+            }
+        }
+        auto tol = float(params.tolerance);
+        for (size_t b = 0; b < bins; ++b) {
+            auto r = binned[b];
+            ghostScratch[b] = filled && depth > 1 && r > 0
+                && !near((b + bins - 1) % bins, r, tol) && !near(b, r, tol) && !near((b + 1) % bins, r, tol);
+        }
+        for (size_t b = 0; b < bins; ++b) {
+            auto r = binned[b];
+            ring[b * depth + head] = r;
+            auto win = window(b);
+            if (r > 0) {
+                auto it = std::upper_bound(win, win + valid[b], r);
+                std::copy_backward(it, win + valid[b], win + valid[b] + 1);
+                *it = r;
+                valid[b]++;
+            }
+            if (valid[b] < params.minHits || !valid[b]) {
+                filtered[b] = 0;
+            } else if (params.mode == Min) {
+                filtered[b] = win[0];
+            } else {
+                filtered[b] = win[valid[b] / 2];
+            }
+        }
+        head = (head + 1) % depth;
+        filled = std::min(filled + 1, depth);
+        std::lock_guard lock(mtx);
+        outRanges.swap(filtered);
+        outBinned.swap(binned);
+        outGhosts.swap(ghostScratch);
+        hits++;
+    }
+
+    // Per bin, bin i centered at (i + 0.5) * 2pi / bins, 0 for no return
+    vector<float> Ranges() const {
+        std::lock_guard lock(mtx);
+        return outRanges;
+    }
+
+    vector<float> Binned() const {
+        std::lock_guard lock(mtx);
+        return outBinned;
+    }
+
+    vector<uint8_t> Ghosts() const {
+        std::lock_guard lock(mtx);
+        return outGhosts;
+    }
+
+    size_t Bins() const noexcept {
+        return params.bins;
+    }
+
+    uint64_t Hits() const {
+        std::lock_guard lock(mtx);
+        return hits;
+    }
+
+private:
+    float* window(size_t b) noexcept {
+        return sorted.data() + b * params.depth;
+    }
+
+    bool near(size_t b, float r, float tol) noexcept {
+        auto win = window(b);
+        auto it = std::lower_bound(win, win + valid[b], r - tol);
+        return it != win + valid[b] && *it <= r + tol;
+    }
+
+    Params params;
+    // [bin][slot], slot head is the oldest scan
+    vector<float> ring;
+    // [bin][0..valid), ascending
+    vector<float> sorted;
+    vector<size_t> valid;
+    size_t head = 0;
+    size_t filled = 0;
+    // Per scan scratch, swapped with the outputs
+    vector<float> binned;
+    vector<float> filtered;
+    vector<uint8_t> ghostScratch;
+    vector<float> outRanges;
+    vector<float> outBinned;
+    vector<uint8_t> outGhosts;
+    uint64_t hits = 0;
+    mutable std::mutex mtx;
+};
+
+}
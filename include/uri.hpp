@@ -5,15 +5,33 @@
 namespace bang 
 {
 
+template<typename T>
+T ParseNum(string_view src, string_view what) {
+    T res{};
+    auto r = std::from_chars(src.data(), src.data() + src.size(), res);
+    if (r.ec != std::errc{} || r.ptr != src.data() + src.size()) {
+        throw Err("Invalid param: {}", what);
+    }
+    return res;
+}
+
+// Calls fn for every non-empty part of src between separators
+template<typename F>
+void Split(string_view src, char sep, F const& fn) {
+    while (src.size()) {
+        auto found = src.find(sep);
+        if (auto part = src.substr(0, found); part.size()) {
+            fn(part);
+        }
+        src = found == string_view::npos ? string_view{} : src.substr(found + 1);
+    }
+}
+
 template<typename Map, typename T>
 T GetOr(Map const& m, string_view k, T adef) {
     if (auto it = m.find(k); it != m.end()) {
-        if constexpr (std::is_integral_v<T>) {
-            auto r = std::from_chars(it->second.data(), it->second.data() + it->second.size(), adef);
-            if (r.ec != std::errc{}) {
-                throw Err("Invalid param: {}", k);
-            }
-            return adef;
+        if constexpr (std::is_arithmetic_v<T>) {
+            return ParseNum<T>(it->second, k);
         } else {
             return it->second;
         }
@@ -0,0 +1,212 @@
+"""Message codegen: msg/*.msg -> firmware/gen/Msg*.h and script/gen/Msg*.py
+
+Same command line as ros-iface's generate.py:
+    generate.py --name MsgX msg/X.msg [--out_py script/gen/MsgX.py] [--out_c firmware/gen/MsgX.h]
+
+A .msg file has one `type name` field per line, plus `uint16 Type = N`.
+Fields go on the wire little-endian, in order, without padding.
+"""
+import argparse
+import re
+import sys
+from typing import List, Tuple
+
+C_TYPES = {
+    "uint8": "uint8_t", "int8": "int8_t", "uint16": "uint16_t", "int16": "int16_t",
+    "uint32": "uint32_t", "int32": "int32_t", "uint64": "uint64_t", "int64": "int64_t",
+    "float32": "float32_t", "float64": "float64_t",
+}
+STRUCT_CODES = {
+    "uint8": "B", "int8": "b", "uint16": "H", "int16": "h", "uint32": "I", "int32": "i",
+    "uint64": "Q", "int64": "q", "float32": "f", "float64": "d",
+}
+NUMPY_TYPES = {
+    "uint8": "u1", "int8": "i1", "uint16": "<u2", "int16": "<i2", "uint32": "<u4", "int32": "<i4",
+    "uint64": "<u8", "int64": "<i8", "float32": "<f4", "float64": "<f8",
+}
+SIZES = {
+    "uint8": 1, "int8": 1, "uint16": 2, "int16": 2, "uint32": 4, "int32": 4,
+    "uint64": 8, "int64": 8, "float32": 4, "float64": 8,
+}
+
+Fields = List[Tuple[str, str]]
+
+def parse(path: str) -> Tuple[Fields, int]:
+    fields: Fields = []
+    type_id = None
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            if m := re.fullmatch(r"uint16\s+Type\s*=\s*(\d+)", line):
+                type_id = int(m.group(1))
+                continue
+            m = re.fullmatch(r"(\w+)\s+(\w+)", line)
+            if not m or m.group(1) not in C_TYPES:
+                raise SystemExit(f"{path}:{lineno}: expected `<type> <name>`, got: {line}")
+            fields.append((m.group(1), m.group(2)))
+    if type_id is None:
+        raise SystemExit(f"{path}: missing `uint16 Type = N`")
+    return fields, type_id
+
+def naturally_packed(fields: Fields) -> bool:
+    "Every field aligned and no tail padding: the C struct is the wire layout"
+    offset = 0
+    for t, _ in fields:
+        if offset % SIZES[t]:
+            return False
+        offset += SIZES[t]
+    return offset % max((SIZES[t] for t, _ in fields), default=1) == 0
+
+def gen_c(name: str, fields: Fields, type_id: int) -> str:
+    total = sum(SIZES[t] for t, _ in fields)
+    fast = naturally_packed(fields)
+    out = [
+        "#pragma once",
+        "#include <stdint.h>",
+        "#include <stddef.h>",
+        "#include <string.h>",
+        "",
+        "typedef float float32_t;",
+        "typedef double float64_t;",
+        "",
+    ]
+    if fast:
+        out += [
+            "#ifndef MSG_LITTLE_ENDIAN",
+            "#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__",
+            "#define MSG_LITTLE_ENDIAN 1",
+            "#else",
+            "#define MSG_LITTLE_ENDIAN 0",
+            "#endif",
+            "#endif",
+            "",
+        ]
+    out += [
+        "typedef enum {",
+        f"    {name}_Type = {type_id},",
+        f"}} {name}_;",
+        "",
+        f"struct {name} {{",
+        *(f"    {C_TYPES[t]} {n};" for t, n in fields),
+        "};",
+        "",
+    ]
+    if fast:
+        out += [
+            "// Naturally packed: wire layout is the in-memory layout",
+            "#if MSG_LITTLE_ENDIAN",
+            f'static_assert(sizeof({name}) == {total}, "{name}: unexpected padding");',
+        ]
+        offset = 0
+        for t, n in fields:
+            out.append(f'static_assert(offsetof({name}, {n}) == {offset}, "{name}: unexpected offset of {n}");')
+            offset += SIZES[t]
+        out += ["#endif", ""]
+
+    def body(whole: str, per_field) -> List[str]:
+        lines = []
+        if fast:
+            lines += ["#if MSG_LITTLE_ENDIAN", f"    memcpy({whole}, {total});", "#else"]
+        for _, n in fields:
+            lines += per_field(n)
+        if fast:
+            lines += ["#endif"]
+        return lines
+
+    out += [
+        f"static inline size_t parse_{name}({name}* __restrict__ out, const char* __restrict__ src, size_t size) {{",
+        f"    if (size < {total}) return 0;",
+        *body("out, src", lambda n: [
+            f"    memcpy(&out->{n}, src, sizeof(out->{n}));",
+            f"    src += sizeof(out->{n});",
+        ]),
+        f"    return {total};",
+        "}",
+        "",
+        f"static inline size_t dump_{name}(const {name}* __restrict__ obj, char* __restrict__ buff, size_t size) {{",
+        f"    if (size < {total}) return 0;",
+        *body("buff, obj", lambda n: [
+            f"    memcpy(buff, &obj->{n}, sizeof(obj->{n}));",
+            f"    buff += sizeof(obj->{n});",
+        ]),
+        f"    return {total};",
+        "}",
+        "",
+    ]
+    return "\n".join(out)
+
+def gen_py(name: str, fields: Fields, type_id: int) -> str:
+    py_types = {t: "float" if t.startswith("float") else "int" for t in C_TYPES}
+    codes = "".join(STRUCT_CODES[t] for t, _ in fields)
+    dtype = ", ".join(repr((n, NUMPY_TYPES[t])) for t, n in fields)
+    out = [
+        "import struct",
+        "import sys",
+        "from dataclasses import dataclass, fields",
+        "from typing import ClassVar",
+        "try:",
+        "    import numpy as _np",
+        "except ImportError:",
+        "    _np = None",
+        "",
+        "def _numpy():",
+        "    if _np is None:",
+        '        raise ImportError("numpy is required for batch message codecs")',
+        "    return _np",
+        "",
+        "@dataclass",
+        f"class {name}:",
+        *(f"    {n}: {py_types[t]}" for t, n in fields),
+        f"    Type: ClassVar[int] = {type_id}",
+        "",
+        "    @staticmethod",
+        "    def from_buffer(buff):",
+        f"        return {name}(*{name}._s.unpack(buff))",
+        "    def into_buffer(self):",
+        f"        return {name}._s.pack(*tuple(getattr(self, n) for n in {name}._names))",
+        "",
+        "    @staticmethod",
+        "    def from_buffer_batch(buff):",
+        '        "Concatenated payloads -> structured array of dtype"',
+        f"        return _numpy().frombuffer(buff, dtype={name}.dtype)",
+        "    @staticmethod",
+        "    def into_buffer_batch(arr):",
+        '        "Structured array (or anything convertible to dtype) -> concatenated payloads"',
+        f"        return _numpy().ascontiguousarray(arr, dtype={name}.dtype).tobytes()",
+        "",
+        f"{name}._names = tuple(f.name for f in fields({name}))",
+        f'{name}._s = struct.Struct("<{codes}")',
+        f"{name}.dtype = _np.dtype([{dtype}]) if _np else None",
+        "        ",
+        "",
+    ]
+    return "\n".join(out)
+
+def write(path: str, text: str):
+    "Only touch outputs that changed, so configure does not trigger rebuilds"
+    try:
+        with open(path) as f:
+            if f.read() == text:
+                return
+    except FileNotFoundError:
+        pass
+    with open(path, "w") as f:
+        f.write(text)
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--name", required=True)
+    parser.add_argument("source")
+    parser.add_argument("--out_py")
+    parser.add_argument("--out_c")
+    args = parser.parse_args(argv)
+    fields, type_id = parse(args.source)
+    if args.out_c:
+        write(args.out_c, gen_c(args.name, fields, type_id))
+    if args.out_py:
+        write(args.out_py, gen_py(args.name, fields, type_id))
+
+if __name__ == "__main__":
+    sys.exit(main())
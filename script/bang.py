@@ -1,23 +1,34 @@
 #!/usr/bin/env python3
+import asyncio
 from dataclasses import dataclass
+from enum import IntFlag
 import logging
 from math import inf
 from time import sleep
-from typing import Optional, Type
-from .lidar import RP
+from typing import Callable, Dict, List, Optional, Type
+from .reactor import Reactor
+from .lidar import RP, ScanSink, Icp, Grid, Mcl, Tracker, Lines, Reflectors, Temporal, Downsample, feed
 from .arduino import Channel
 from .gen import *
 
 log = logging.getLogger("bang")
+_lookup = {m.Type: m for m in AllMsgs}
+_sizes = {m.Type: m._s.size for m in AllMsgs}
+
+class Streams(IntFlag):
+    "MsgConfigTelemetry.streams"
+    Odom = 1
+    Pose = 2
+    Stats = 4
 
 class _Arduino(Channel):
-    def __init__(self, uri):
+    def __init__(self, uri, reactor: Optional[Reactor] = None):
         self._hadmsg = False
         self._lookup = {}
         self._handlers = {}
         for m in AllMsgs:
             self._lookup[m.Type] = m
-        super().__init__(uri)
+        super().__init__(uri, reactor=reactor)
 
     def _onmessage(self, type: int, body: bytes):
         self._hadmsg = True
@@ -43,9 +54,136 @@ class _Arduino(Channel):
             return func
         return fabric
 
+    def off(self, msg: Type) -> Optional[Callable]:
+        "Drop the handler of msg, returns it so it can be put back with on()"
+        return self._handlers.pop(msg.Type, None)
+
+class AsyncArduino(Channel):
+    """Channel driven by an asyncio loop: io thread only queues frames,
+    the loop drains them in batches when the channel's fd becomes readable.
+    Create it from a coroutine, or pass the loop it will run on"""
+    def __init__(self, uri, loop: Optional[asyncio.AbstractEventLoop] = None,
+                 reactor: Optional[Reactor] = None):
+        self._loop = loop or asyncio.get_running_loop()
+        self._lookup = {}
+        self._handlers = {}
+        self._acks: Dict[int, asyncio.Future] = {}
+        self._pending = []
+        # Shared by every recv_batch() waiter
+        self._wake = asyncio.Event()
+        for m in AllMsgs:
+            self._lookup[m.Type] = m
+        super().__init__(uri, queued=True, reactor=reactor)
+        self._loop.add_reader(self.fileno(), self._ready)
+
+    def _onmessage(self, type: int, body: bytes):
+        pass
+
+    def _ready(self):
+        for id in self.recv_acks():
+            fut = self._acks.pop(id, None)
+            if fut is not None and not fut.done():
+                fut.set_result(None)
+        for type, body in Channel.recv_batch(self):
+            t = self._lookup.get(type)
+            if t is None:
+                log.warning(f"Could not find msg for {type =}")
+                continue
+            try:
+                msg = t.from_buffer(body)
+            except Exception as e:
+                log.error(f"While receiving msg {type=} => {e}")
+                continue
+            h = self._handlers.get(type)
+            if h is None:
+                self._pending.append(msg)
+            else:
+                h(msg)
+        if self._pending:
+            self._wake.set()
+
+    async def recv_batch(self) -> List:
+        "Wait for at least one message without a registered handler"
+        while not self._pending:
+            self._wake.clear()
+            await self._wake.wait()
+        res, self._pending = self._pending, []
+        return res
+
+    def send(self, msg):
+        super().send(msg.Type, msg.into_buffer())
+
+    async def send_with_ack(self, msg, timeout: float = 1.):
+        id = self.send_request(msg.Type, msg.into_buffer())
+        fut = self._loop.create_future()
+        self._acks[id] = fut
+        try:
+            await asyncio.wait_for(fut, timeout)
+        finally:
+            if self._acks.pop(id, None) is not None:
+                self.forget(id)
+
+    def on(self, msg: Type):
+        def fabric(func):
+            if not msg.Type in self._lookup:
+                raise RuntimeError(f"Unsupported msg type: {msg.Type}")
+            self._handlers[msg.Type] = func
+            return func
+        return fabric
+
+    def off(self, msg: Type) -> Optional[Callable]:
+        "Drop the handler of msg, returns it so it can be put back with on()"
+        return self._handlers.pop(msg.Type, None)
+
+    def close(self):
+        self._loop.remove_reader(self.fileno())
+
+def recv_arrays(channel: Channel) -> Dict[Type, "numpy.ndarray"]:
+    """Drain a queued channel into one structured array per message type,
+    for logging and analysis of high rate streams. Frames of unknown types
+    or the wrong size are dropped and counted in channel.malformed"""
+    res = {}
+    for type, bodies in channel.recv_grouped(_sizes).items():
+        t = _lookup[type]
+        try:
+            res[t] = t.from_buffer_batch(bodies)
+        except Exception as e:
+            log.error(f"While decoding batch of {type=} => {e}")
+    return res
+
+class Pins:
+    """Debounced pin subscriptions: firmware pushes MsgPinStates only when
+    a state changes, callbacks get (slot, state) for changed slots"""
+    def __init__(self, arduino):
+        self._arduino = arduino
+        self._callbacks: Dict[int, Callable[[int, bool], None]] = {}
+        self.states = 0
+        arduino.on(MsgPinStates)(self._onstates)
+
+    def subscribe(self, slot: int, pin: int, func: Callable[[int, bool], None],
+                  debounce_ms: int = 5, pullup: bool = False):
+        self._callbacks[slot] = func
+        self._arduino.send(MsgSubscribePin(slot, pin, debounce_ms, pullup))
+
+    def unsubscribe(self, slot: int):
+        self._callbacks.pop(slot, None)
+        self._arduino.send(MsgSubscribePin(slot, -1, 0, False))
+
+    def __getitem__(self, slot: int) -> bool:
+        return bool(self.states >> slot & 1)
+
+    def _onstates(self, msg: MsgPinStates):
+        self.states = msg.states
+        for slot, func in self._callbacks.items():
+            if msg.changed >> slot & 1:
+                try:
+                    func(slot, bool(msg.states >> slot & 1))
+                except Exception as e:
+                    log.error(f"Pin slot {slot} callback => {e}")
+
 class _Lidar(RP):
-    def __init__(self, uri):
-        super().__init__(uri)
+    def __init__(self, uri, reactor: Optional[Reactor] = None):
+        super().__init__(uri, reactor)
 
     def _onscan(self, data: tuple):
         pass
@@ -61,12 +199,20 @@ class Bang:
     
     arduino_uri: Optional[str] = "serial:/dev/ttyUSB0"
     lidar_uri: Optional[str] = "serial:/dev/ttyACM0"
+    # Lidar polling, its native sinks and _onscan run on a reactor of this
+    # many threads (0 keeps a thread of its own). Arduino serial I/O always
+    # keeps its own thread, so a slow scan never delays odometry or acks.
+    reactor_threads: int = 1
+    reactor_cpus: Optional[List[int]] = None
 
     def __post_init__(self) -> None:
+        self._reactor = None
+        if self.reactor_threads:
+            self._reactor = Reactor(self.reactor_threads, self.reactor_cpus or [])
         if self.arduino_uri:
             self._arduino = _Arduino(self.arduino_uri)
         if self.lidar_uri:
-            self._lidar = _Lidar(self.lidar_uri)
+            self._lidar = _Lidar(self.lidar_uri, self._reactor)
         while not self.arduino._hadmsg: sleep(0.1)
         self.arduino.send(MsgTest(True))
         self.arduino.send(MsgTest(False))
@@ -76,6 +222,11 @@ class Bang:
     def lidar(self):
         return self._lidar
 
+    @property
+    def reactor(self) -> Optional[Reactor]:
+        "Scan processing reactor, pass it to Grid and Mcl to share their pools"
+        return self._reactor
+
     @property
     def arduino(self):
         return self._arduino
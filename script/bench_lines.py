@@ -0,0 +1,52 @@
+from statistics import mean, median
+from threading import Event
+from typing import List
+import numpy as np
+from .lidar import RP, ScanSink, Lines, feed
+
+def record(lidar: RP, count: int = 100, path: str = "scans.npz", timeout: float = 30.) -> List[np.ndarray]:
+    """Save the next count scans of a started lidar as arrays[n, 3] of (range, intensity, theta).
+    Replaces the lidar's _onscan until done"""
+    scans: List[np.ndarray] = []
+    done = Event()
+    prev = lidar._onscan
+    def onscan(data: tuple):
+        if len(scans) < count:
+            scans.append(np.asarray(data, dtype=np.float32).reshape(-1, 3))
+        if len(scans) >= count:
+            done.set()
+    lidar._onscan = onscan
+    try:
+        if not done.wait(timeout):
+            raise TimeoutError(f"Record: got {len(scans)}/{count} scans")
+    finally:
+        lidar._onscan = prev
+    np.savez_compressed(path, *scans)
+    return scans
+
+def load(path: str = "scans.npz") -> List[np.ndarray]:
+    with np.load(path) as f:
+        return [f[f"arr_{i}"] for i in range(len(f.files))]
+
+def bench(sink: ScanSink, scans: List[np.ndarray], repeat: int = 10) -> dict:
+    "Milliseconds spent in the sink per scan, first pass excluded as warm-up"
+    for scan in scans:
+        feed(sink, scan)
+    times = [feed(sink, scan) * 1000 for _ in range(repeat) for scan in scans]
+    times.sort()
+    return {
+        "scans": len(times),
+        "mean": mean(times),
+        "median": median(times),
+        "p99": times[min(len(times) - 1, int(len(times) * 0.99))],
+        "max": times[-1],
+    }
+
+if __name__ == "__main__":
+    import sys
+    scans = load(sys.argv[1] if len(sys.argv) > 1 else "scans.npz")
+    lines = Lines()
+    stats = bench(lines, scans)
+    print(" ".join(f"{k}={v:.3f}" if isinstance(v, float) else f"{k}={v}" for k, v in stats.items()), "ms")
+    feed(lines, scans[-1])
+    print(f"{len(lines.lines())} lines, {len(lines.corners())} corners in the last scan")
@@ -0,0 +1,41 @@
+import struct
+import sys
+from dataclasses import dataclass, fields
+from typing import ClassVar
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+def _numpy():
+    if _np is None:
+        raise ImportError("numpy is required for batch message codecs")
+    return _np
+
+@dataclass
+class MsgCaptureArm:
+    motor: int
+    decimation: int
+    speedMm: int
+    samples: int
+    Type: ClassVar[int] = 16
+
+    @staticmethod
+    def from_buffer(buff):
+        return MsgCaptureArm(*MsgCaptureArm._s.unpack(buff))
+    def into_buffer(self):
+        return MsgCaptureArm._s.pack(*tuple(getattr(self, n) for n in MsgCaptureArm._names))
+
+    @staticmethod
+    def from_buffer_batch(buff):
+        "Concatenated payloads -> structured array of dtype"
+        return _numpy().frombuffer(buff, dtype=MsgCaptureArm.dtype)
+    @staticmethod
+    def into_buffer_batch(arr):
+        "Structured array (or anything convertible to dtype) -> concatenated payloads"
+        return _numpy().ascontiguousarray(arr, dtype=MsgCaptureArm.dtype).tobytes()
+
+MsgCaptureArm._names = tuple(f.name for f in fields(MsgCaptureArm))
+MsgCaptureArm._s = struct.Struct("<BBhH")
+MsgCaptureArm.dtype = _np.dtype([('motor', 'u1'), ('decimation', 'u1'), ('speedMm', '<i2'), ('samples', '<u2')]) if _np else None
+        
@@ -0,0 +1,45 @@
+import struct
+import sys
+from dataclasses import dataclass, fields
+from typing import ClassVar
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+def _numpy():
+    if _np is None:
+        raise ImportError("numpy is required for batch message codecs")
+    return _np
+
+@dataclass
+class MsgCaptureSample:
+    index: int
+    count: int
+    motor: int
+    aborted: int
+    targSpd: int
+    currSpd: int
+    pwm: int
+    dX: int
+    Type: ClassVar[int] = 17
+
+    @staticmethod
+    def from_buffer(buff):
+        return MsgCaptureSample(*MsgCaptureSample._s.unpack(buff))
+    def into_buffer(self):
+        return MsgCaptureSample._s.pack(*tuple(getattr(self, n) for n in MsgCaptureSample._names))
+
+    @staticmethod
+    def from_buffer_batch(buff):
+        "Concatenated payloads -> structured array of dtype"
+        return _numpy().frombuffer(buff, dtype=MsgCaptureSample.dtype)
+    @staticmethod
+    def into_buffer_batch(arr):
+        "Structured array (or anything convertible to dtype) -> concatenated payloads"
+        return _numpy().ascontiguousarray(arr, dtype=MsgCaptureSample.dtype).tobytes()
+
+MsgCaptureSample._names = tuple(f.name for f in fields(MsgCaptureSample))
+MsgCaptureSample._s = struct.Struct("<HHBBhhhh")
+MsgCaptureSample.dtype = _np.dtype([('index', '<u2'), ('count', '<u2'), ('motor', 'u1'), ('aborted', 'u1'), ('targSpd', '<i2'), ('currSpd', '<i2'), ('pwm', '<i2'), ('dX', '<i2')]) if _np else None
+        
@@ -2,6 +2,15 @@ import struct
 import sys
 from dataclasses import dataclass, fields
 from typing import ClassVar
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+def _numpy():
+    if _np is None:
+        raise ImportError("numpy is required for batch message codecs")
+    return _np
 
 @dataclass
 class MsgConfigMotor:
@@ -23,6 +32,16 @@ class MsgConfigMotor:
     def into_buffer(self):
         return MsgConfigMotor._s.pack(*tuple(getattr(self, n) for n in MsgConfigMotor._names))
 
+    @staticmethod
+    def from_buffer_batch(buff):
+        "Concatenated payloads -> structured array of dtype"
+        return _numpy().frombuffer(buff, dtype=MsgConfigMotor.dtype)
+    @staticmethod
+    def into_buffer_batch(arr):
+        "Structured array (or anything convertible to dtype) -> concatenated payloads"
+        return _numpy().ascontiguousarray(arr, dtype=MsgConfigMotor.dtype).tobytes()
+
 MsgConfigMotor._names = tuple(f.name for f in fields(MsgConfigMotor))
 MsgConfigMotor._s = struct.Struct("<Bfiffffffi")
+MsgConfigMotor.dtype = _np.dtype([('num', 'u1'), ('radius', '<f4'), ('angleDegrees', '<i4'), ('interCoeff', '<f4'), ('propCoeff', '<f4'), ('diffCoeff', '<f4'), ('coeff', '<f4'), ('turnMaxSpeed', '<f4'), ('maxSpeed', '<f4'), ('ticksPerRotation', '<i4')]) if _np else None
         
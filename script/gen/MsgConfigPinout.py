@@ -2,6 +2,15 @@ import struct
 import sys
 from dataclasses import dataclass, fields
 from typing import ClassVar
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+def _numpy():
+    if _np is None:
+        raise ImportError("numpy is required for batch message codecs")
+    return _np
 
 @dataclass
 class MsgConfigPinout:
@@ -19,6 +28,16 @@ class MsgConfigPinout:
     def into_buffer(self):
         return MsgConfigPinout._s.pack(*tuple(getattr(self, n) for n in MsgConfigPinout._names))
 
+    @staticmethod
+    def from_buffer_batch(buff):
+        "Concatenated payloads -> structured array of dtype"
+        return _numpy().frombuffer(buff, dtype=MsgConfigPinout.dtype)
+    @staticmethod
+    def into_buffer_batch(arr):
+        "Structured array (or anything convertible to dtype) -> concatenated payloads"
+        return _numpy().ascontiguousarray(arr, dtype=MsgConfigPinout.dtype).tobytes()
+
 MsgConfigPinout._names = tuple(f.name for f in fields(MsgConfigPinout))
 MsgConfigPinout._s = struct.Struct("<Bbbbbb")
+MsgConfigPinout.dtype = _np.dtype([('num', 'u1'), ('encoderA', 'i1'), ('encoderB', 'i1'), ('enable', 'i1'), ('fwd', 'i1'), ('back', 'i1')]) if _np else None
         
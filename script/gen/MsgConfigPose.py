@@ -0,0 +1,44 @@
+import struct
+import sys
+from dataclasses import dataclass, fields
+from typing import ClassVar
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+def _numpy():
+    if _np is None:
+        raise ImportError("numpy is required for batch message codecs")
+    return _np
+
+@dataclass
+class MsgConfigPose:
+    enable: int
+    reset: int
+    periodMs: int
+    baseRadius: float
+    thetaCoeff: float
+    xCoeff: float
+    yCoeff: float
+    Type: ClassVar[int] = 13
+
+    @staticmethod
+    def from_buffer(buff):
+        return MsgConfigPose(*MsgConfigPose._s.unpack(buff))
+    def into_buffer(self):
+        return MsgConfigPose._s.pack(*tuple(getattr(self, n) for n in MsgConfigPose._names))
+
+    @staticmethod
+    def from_buffer_batch(buff):
+        "Concatenated payloads -> structured array of dtype"
+        return _numpy().frombuffer(buff, dtype=MsgConfigPose.dtype)
+    @staticmethod
+    def into_buffer_batch(arr):
+        "Structured array (or anything convertible to dtype) -> concatenated payloads"
+        return _numpy().ascontiguousarray(arr, dtype=MsgConfigPose.dtype).tobytes()
+
+MsgConfigPose._names = tuple(f.name for f in fields(MsgConfigPose))
+MsgConfigPose._s = struct.Struct("<BBHffff")
+MsgConfigPose.dtype = _np.dtype([('enable', 'u1'), ('reset', 'u1'), ('periodMs', '<u2'), ('baseRadius', '<f4'), ('thetaCoeff', '<f4'), ('xCoeff', '<f4'), ('yCoeff', '<f4')]) if _np else None
+        
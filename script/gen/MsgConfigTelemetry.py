@@ -0,0 +1,41 @@
+import struct
+import sys
+from dataclasses import dataclass, fields
+from typing import ClassVar
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+def _numpy():
+    if _np is None:
+        raise ImportError("numpy is required for batch message codecs")
+    return _np
+
+@dataclass
+class MsgConfigTelemetry:
+    odomPeriodMs: int
+    statsPeriodMs: int
+    echo: int
+    streams: int
+    Type: ClassVar[int] = 15
+
+    @staticmethod
+    def from_buffer(buff):
+        return MsgConfigTelemetry(*MsgConfigTelemetry._s.unpack(buff))
+    def into_buffer(self):
+        return MsgConfigTelemetry._s.pack(*tuple(getattr(self, n) for n in MsgConfigTelemetry._names))
+
+    @staticmethod
+    def from_buffer_batch(buff):
+        "Concatenated payloads -> structured array of dtype"
+        return _numpy().frombuffer(buff, dtype=MsgConfigTelemetry.dtype)
+    @staticmethod
+    def into_buffer_batch(arr):
+        "Structured array (or anything convertible to dtype) -> concatenated payloads"
+        return _numpy().ascontiguousarray(arr, dtype=MsgConfigTelemetry.dtype).tobytes()
+
+MsgConfigTelemetry._names = tuple(f.name for f in fields(MsgConfigTelemetry))
+MsgConfigTelemetry._s = struct.Struct("<HHBB")
+MsgConfigTelemetry.dtype = _np.dtype([('odomPeriodMs', '<u2'), ('statsPeriodMs', '<u2'), ('echo', 'u1'), ('streams', 'u1')]) if _np else None
+        
@@ -2,6 +2,15 @@ import struct
 import sys
 from dataclasses import dataclass, fields
 from typing import ClassVar
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+def _numpy():
+    if _np is None:
+        raise ImportError("numpy is required for batch message codecs")
+    return _np
 
 @dataclass
 class MsgEcho:
@@ -15,6 +24,16 @@ class MsgEcho:
     def into_buffer(self):
         return MsgEcho._s.pack(*tuple(getattr(self, n) for n in MsgEcho._names))
 
+    @staticmethod
+    def from_buffer_batch(buff):
+        "Concatenated payloads -> structured array of dtype"
+        return _numpy().frombuffer(buff, dtype=MsgEcho.dtype)
+    @staticmethod
+    def into_buffer_batch(arr):
+        "Structured array (or anything convertible to dtype) -> concatenated payloads"
+        return _numpy().ascontiguousarray(arr, dtype=MsgEcho.dtype).tobytes()
+
 MsgEcho._names = tuple(f.name for f in fields(MsgEcho))
 MsgEcho._s = struct.Struct("<HI")
+MsgEcho.dtype = _np.dtype([('type', '<u2'), ('size', '<u4')]) if _np else None
         
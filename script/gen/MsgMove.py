@@ -2,6 +2,15 @@ import struct
 import sys
 from dataclasses import dataclass, fields
 from typing import ClassVar
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+def _numpy():
+    if _np is None:
+        raise ImportError("numpy is required for batch message codecs")
+    return _np
 
 @dataclass
 class MsgMove:
@@ -16,6 +25,16 @@ class MsgMove:
     def into_buffer(self):
         return MsgMove._s.pack(*tuple(getattr(self, n) for n in MsgMove._names))
 
+    @staticmethod
+    def from_buffer_batch(buff):
+        "Concatenated payloads -> structured array of dtype"
+        return _numpy().frombuffer(buff, dtype=MsgMove.dtype)
+    @staticmethod
+    def into_buffer_batch(arr):
+        "Structured array (or anything convertible to dtype) -> concatenated payloads"
+        return _numpy().ascontiguousarray(arr, dtype=MsgMove.dtype).tobytes()
+
 MsgMove._names = tuple(f.name for f in fields(MsgMove))
 MsgMove._s = struct.Struct("<hhh")
+MsgMove.dtype = _np.dtype([('x', '<i2'), ('y', '<i2'), ('theta', '<i2')]) if _np else None
         
@@ -2,6 +2,15 @@ import struct
 import sys
 from dataclasses import dataclass, fields
 from typing import ClassVar
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+def _numpy():
+    if _np is None:
+        raise ImportError("numpy is required for batch message codecs")
+    return _np
 
 @dataclass
 class MsgOdom:
@@ -16,6 +25,16 @@ class MsgOdom:
     def into_buffer(self):
         return MsgOdom._s.pack(*tuple(getattr(self, n) for n in MsgOdom._names))
 
+    @staticmethod
+    def from_buffer_batch(buff):
+        "Concatenated payloads -> structured array of dtype"
+        return _numpy().frombuffer(buff, dtype=MsgOdom.dtype)
+    @staticmethod
+    def into_buffer_batch(arr):
+        "Structured array (or anything convertible to dtype) -> concatenated payloads"
+        return _numpy().ascontiguousarray(arr, dtype=MsgOdom.dtype).tobytes()
+
 MsgOdom._names = tuple(f.name for f in fields(MsgOdom))
 MsgOdom._s = struct.Struct("<bbh")
+MsgOdom.dtype = _np.dtype([('num', 'i1'), ('aux', 'i1'), ('ddist_mm', '<i2')]) if _np else None
         
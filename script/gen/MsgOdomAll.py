@@ -0,0 +1,42 @@
+import struct
+import sys
+from dataclasses import dataclass, fields
+from typing import ClassVar
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+def _numpy():
+    if _np is None:
+        raise ImportError("numpy is required for batch message codecs")
+    return _np
+
+@dataclass
+class MsgOdomAll:
+    micros: int
+    seq: int
+    ddist0_mm: int
+    ddist1_mm: int
+    ddist2_mm: int
+    Type: ClassVar[int] = 10
+
+    @staticmethod
+    def from_buffer(buff):
+        return MsgOdomAll(*MsgOdomAll._s.unpack(buff))
+    def into_buffer(self):
+        return MsgOdomAll._s.pack(*tuple(getattr(self, n) for n in MsgOdomAll._names))
+
+    @staticmethod
+    def from_buffer_batch(buff):
+        "Concatenated payloads -> structured array of dtype"
+        return _numpy().frombuffer(buff, dtype=MsgOdomAll.dtype)
+    @staticmethod
+    def into_buffer_batch(arr):
+        "Structured array (or anything convertible to dtype) -> concatenated payloads"
+        return _numpy().ascontiguousarray(arr, dtype=MsgOdomAll.dtype).tobytes()
+
+MsgOdomAll._names = tuple(f.name for f in fields(MsgOdomAll))
+MsgOdomAll._s = struct.Struct("<IHhhh")
+MsgOdomAll.dtype = _np.dtype([('micros', '<u4'), ('seq', '<u2'), ('ddist0_mm', '<i2'), ('ddist1_mm', '<i2'), ('ddist2_mm', '<i2')]) if _np else None
+        
@@ -2,6 +2,15 @@ import struct
 import sys
 from dataclasses import dataclass, fields
 from typing import ClassVar
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+def _numpy():
+    if _np is None:
+        raise ImportError("numpy is required for batch message codecs")
+    return _np
 
 @dataclass
 class MsgPid:
@@ -17,6 +26,16 @@ class MsgPid:
     def into_buffer(self):
         return MsgPid._s.pack(*tuple(getattr(self, n) for n in MsgPid._names))
 
+    @staticmethod
+    def from_buffer_batch(buff):
+        "Concatenated payloads -> structured array of dtype"
+        return _numpy().frombuffer(buff, dtype=MsgPid.dtype)
+    @staticmethod
+    def into_buffer_batch(arr):
+        "Structured array (or anything convertible to dtype) -> concatenated payloads"
+        return _numpy().ascontiguousarray(arr, dtype=MsgPid.dtype).tobytes()
+
 MsgPid._names = tuple(f.name for f in fields(MsgPid))
 MsgPid._s = struct.Struct("<biii")
+MsgPid.dtype = _np.dtype([('motor', 'i1'), ('p', '<i4'), ('i', '<i4'), ('d', '<i4')]) if _np else None
         
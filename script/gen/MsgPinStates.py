@@ -0,0 +1,40 @@
+import struct
+import sys
+from dataclasses import dataclass, fields
+from typing import ClassVar
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+def _numpy():
+    if _np is None:
+        raise ImportError("numpy is required for batch message codecs")
+    return _np
+
+@dataclass
+class MsgPinStates:
+    micros: int
+    states: int
+    changed: int
+    Type: ClassVar[int] = 19
+
+    @staticmethod
+    def from_buffer(buff):
+        return MsgPinStates(*MsgPinStates._s.unpack(buff))
+    def into_buffer(self):
+        return MsgPinStates._s.pack(*tuple(getattr(self, n) for n in MsgPinStates._names))
+
+    @staticmethod
+    def from_buffer_batch(buff):
+        "Concatenated payloads -> structured array of dtype"
+        return _numpy().frombuffer(buff, dtype=MsgPinStates.dtype)
+    @staticmethod
+    def into_buffer_batch(arr):
+        "Structured array (or anything convertible to dtype) -> concatenated payloads"
+        return _numpy().ascontiguousarray(arr, dtype=MsgPinStates.dtype).tobytes()
+
+MsgPinStates._names = tuple(f.name for f in fields(MsgPinStates))
+MsgPinStates._s = struct.Struct("<IHH")
+MsgPinStates.dtype = _np.dtype([('micros', '<u4'), ('states', '<u2'), ('changed', '<u2')]) if _np else None
+        
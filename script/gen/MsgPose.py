@@ -0,0 +1,42 @@
+import struct
+import sys
+from dataclasses import dataclass, fields
+from typing import ClassVar
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+def _numpy():
+    if _np is None:
+        raise ImportError("numpy is required for batch message codecs")
+    return _np
+
+@dataclass
+class MsgPose:
+    micros: int
+    seq: int
+    x: float
+    y: float
+    theta: float
+    Type: ClassVar[int] = 14
+
+    @staticmethod
+    def from_buffer(buff):
+        return MsgPose(*MsgPose._s.unpack(buff))
+    def into_buffer(self):
+        return MsgPose._s.pack(*tuple(getattr(self, n) for n in MsgPose._names))
+
+    @staticmethod
+    def from_buffer_batch(buff):
+        "Concatenated payloads -> structured array of dtype"
+        return _numpy().frombuffer(buff, dtype=MsgPose.dtype)
+    @staticmethod
+    def into_buffer_batch(arr):
+        "Structured array (or anything convertible to dtype) -> concatenated payloads"
+        return _numpy().ascontiguousarray(arr, dtype=MsgPose.dtype).tobytes()
+
+MsgPose._names = tuple(f.name for f in fields(MsgPose))
+MsgPose._s = struct.Struct("<IHfff")
+MsgPose.dtype = _np.dtype([('micros', '<u4'), ('seq', '<u2'), ('x', '<f4'), ('y', '<f4'), ('theta', '<f4')]) if _np else None
+        
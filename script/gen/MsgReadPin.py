@@ -2,6 +2,15 @@ import struct
 import sys
 from dataclasses import dataclass, fields
 from typing import ClassVar
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+def _numpy():
+    if _np is None:
+        raise ImportError("numpy is required for batch message codecs")
+    return _np
 
 @dataclass
 class MsgReadPin:
@@ -16,6 +25,16 @@ class MsgReadPin:
     def into_buffer(self):
         return MsgReadPin._s.pack(*tuple(getattr(self, n) for n in MsgReadPin._names))
 
+    @staticmethod
+    def from_buffer_batch(buff):
+        "Concatenated payloads -> structured array of dtype"
+        return _numpy().frombuffer(buff, dtype=MsgReadPin.dtype)
+    @staticmethod
+    def into_buffer_batch(arr):
+        "Structured array (or anything convertible to dtype) -> concatenated payloads"
+        return _numpy().ascontiguousarray(arr, dtype=MsgReadPin.dtype).tobytes()
+
 MsgReadPin._names = tuple(f.name for f in fields(MsgReadPin))
 MsgReadPin._s = struct.Struct("<bbb")
+MsgReadPin.dtype = _np.dtype([('pin', 'i1'), ('value', 'i1'), ('pullup', 'i1')]) if _np else None
         
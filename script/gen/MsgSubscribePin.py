@@ -0,0 +1,41 @@
+import struct
+import sys
+from dataclasses import dataclass, fields
+from typing import ClassVar
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+def _numpy():
+    if _np is None:
+        raise ImportError("numpy is required for batch message codecs")
+    return _np
+
+@dataclass
+class MsgSubscribePin:
+    slot: int
+    pin: int
+    debounceMs: int
+    pullup: int
+    Type: ClassVar[int] = 18
+
+    @staticmethod
+    def from_buffer(buff):
+        return MsgSubscribePin(*MsgSubscribePin._s.unpack(buff))
+    def into_buffer(self):
+        return MsgSubscribePin._s.pack(*tuple(getattr(self, n) for n in MsgSubscribePin._names))
+
+    @staticmethod
+    def from_buffer_batch(buff):
+        "Concatenated payloads -> structured array of dtype"
+        return _numpy().frombuffer(buff, dtype=MsgSubscribePin.dtype)
+    @staticmethod
+    def into_buffer_batch(arr):
+        "Structured array (or anything convertible to dtype) -> concatenated payloads"
+        return _numpy().ascontiguousarray(arr, dtype=MsgSubscribePin.dtype).tobytes()
+
+MsgSubscribePin._names = tuple(f.name for f in fields(MsgSubscribePin))
+MsgSubscribePin._s = struct.Struct("<BbBB")
+MsgSubscribePin.dtype = _np.dtype([('slot', 'u1'), ('pin', 'i1'), ('debounceMs', 'u1'), ('pullup', 'u1')]) if _np else None
+        
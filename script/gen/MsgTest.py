@@ -2,6 +2,15 @@ import struct
 import sys
 from dataclasses import dataclass, fields
 from typing import ClassVar
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+def _numpy():
+    if _np is None:
+        raise ImportError("numpy is required for batch message codecs")
+    return _np
 
 @dataclass
 class MsgTest:
@@ -14,6 +23,16 @@ class MsgTest:
     def into_buffer(self):
         return MsgTest._s.pack(*tuple(getattr(self, n) for n in MsgTest._names))
 
+    @staticmethod
+    def from_buffer_batch(buff):
+        "Concatenated payloads -> structured array of dtype"
+        return _numpy().frombuffer(buff, dtype=MsgTest.dtype)
+    @staticmethod
+    def into_buffer_batch(arr):
+        "Structured array (or anything convertible to dtype) -> concatenated payloads"
+        return _numpy().ascontiguousarray(arr, dtype=MsgTest.dtype).tobytes()
+
 MsgTest._names = tuple(f.name for f in fields(MsgTest))
 MsgTest._s = struct.Struct("<B")
+MsgTest.dtype = _np.dtype([('led', 'u1')]) if _np else None
         
@@ -0,0 +1,39 @@
+import struct
+import sys
+from dataclasses import dataclass, fields
+from typing import ClassVar
+try:
+    import numpy as _np
+except ImportError:
+    _np = None
+
+def _numpy():
+    if _np is None:
+        raise ImportError("numpy is required for batch message codecs")
+    return _np
+
+@dataclass
+class MsgTxStats:
+    overflows: int
+    peak: int
+    Type: ClassVar[int] = 11
+
+    @staticmethod
+    def from_buffer(buff):
+        return MsgTxStats(*MsgTxStats._s.unpack(buff))
+    def into_buffer(self):
+        return MsgTxStats._s.pack(*tuple(getattr(self, n) for n in MsgTxStats._names))
+
+    @staticmethod
+    def from_buffer_batch(buff):
+        "Concatenated payloads -> structured array of dtype"
+        return _numpy().frombuffer(buff, dtype=MsgTxStats.dtype)
+    @staticmethod
+    def into_buffer_batch(arr):
+        "Structured array (or anything convertible to dtype) -> concatenated payloads"
+        return _numpy().ascontiguousarray(arr, dtype=MsgTxStats.dtype).tobytes()
+
+MsgTxStats._names = tuple(f.name for f in fields(MsgTxStats))
+MsgTxStats._s = struct.Struct("<HH")
+MsgTxStats.dtype = _np.dtype([('overflows', '<u2'), ('peak', '<u2')]) if _np else None
+        
@@ -6,6 +6,15 @@ from .MsgReadPin import *
 from .MsgTest import *
 from .MsgConfigPinout import *
 from .MsgEcho import *
+from .MsgOdomAll import *
+from .MsgTxStats import *
+from .MsgConfigPose import *
+from .MsgPose import *
+from .MsgConfigTelemetry import *
+from .MsgCaptureArm import *
+from .MsgCaptureSample import *
+from .MsgSubscribePin import *
+from .MsgPinStates import *
 AllMsgs = [
     MsgMove,
     MsgOdom,
@@ -14,5 +23,14 @@ AllMsgs = [
     MsgReadPin,
     MsgTest,
     MsgConfigPinout,
-    MsgEcho
+    MsgEcho,
+    MsgOdomAll,
+    MsgTxStats,
+    MsgConfigPose,
+    MsgPose,
+    MsgConfigTelemetry,
+    MsgCaptureArm,
+    MsgCaptureSample,
+    MsgSubscribePin,
+    MsgPinStates
 ]
\ No newline at end of file
@@ -1,8 +1,8 @@
 from collections import namedtuple
 from dataclasses import dataclass
 from math import cos, radians, sin
-from typing import List, Tuple
-from .gen import MsgOdom, MsgConfigMotor
+from typing import List, Optional, Tuple
+from .gen import MsgOdom, MsgOdomAll, MsgConfigMotor, MsgConfigPose
 
 Position = namedtuple("Position", ("x", "y", "th"))
 
@@ -27,25 +27,78 @@ class Odom:
         self._mots = tuple(_Mot(c) for c in self.motors)
         self._x = self._y = self._th = 0.
         self._hits = 0
+        self._dropped = 0
+        self._seq: Optional[int] = None
+        self._micros = 0
+        self._dt = 0.
     
     @property
     def hits(self): return self._hits
 
+    @property
+    def dropped(self):
+        "MsgOdomAll frames lost, detected from sequence gaps"
+        return self._dropped
+
+    @property
+    def dt(self):
+        "Seconds between last two MsgOdomAll frames, by firmware clock"
+        return self._dt
+
     def handle(self, msg: MsgOdom):
         if msg.num >= len(self._mots): 
             return False
         else: 
             self._hits += 1
-            self._mots[msg.num].ddist += msg.ddist_mm * 1000.
+            self._mots[msg.num].ddist += msg.ddist_mm / 1000.
             return True
 
+    def handle_all(self, msg: MsgOdomAll):
+        step = (msg.seq - self._seq) & 0xFFFF if self._seq is not None else 0
+        elapsed = (msg.micros - self._micros) & 0xFFFFFFFF
+        # Repeated or backwards seq/micros: firmware restarted, resync
+        if 0 < step < 0x8000 and elapsed < 0x80000000:
+            self._dropped += step - 1
+            self._dt = elapsed / 1e6
+        self._seq = msg.seq
+        self._micros = msg.micros
+        self._hits += 1
+        ddists = (msg.ddist0_mm, msg.ddist1_mm, msg.ddist2_mm)
+        for mot, ddist in zip(self._mots, ddists):
+            mot.ddist += ddist / 1000.
+        return True
+
+    def native(self):
+        "Same geometry and body frame coefficients, integrated along arcs on the io thread, see Channel.attach_odometry()"
+        from .arduino import Odometry as NativeOdometry
+        return NativeOdometry(
+            [m.angleDegrees for m in self.motors],
+            base_radius=self.base_radius,
+            theta_coeff=self.theta_coeff,
+            x_coeff=self.x_coeff,
+            y_coeff=self.y_coeff)
+
+    def firmware(self, period_ms: int = 50, reset: bool = True) -> MsgConfigPose:
+        "Config for the same geometry and body frame coefficients integrated on the MCU (midpoint steps), streamed as MsgPose"
+        return MsgConfigPose(
+            enable=1, reset=int(reset), periodMs=period_ms,
+            baseRadius=self.base_radius, thetaCoeff=self.theta_coeff,
+            xCoeff=self.x_coeff, yCoeff=self.y_coeff)
+
     def update(self) -> Position:
+        "Euler step: x_coeff and y_coeff scale the robot's own axes, then rotate to the world"
         count = len(self._mots)
+        bx = by = dth = 0.
         for mot in self._mots:
-            self._th += mot.ddist / count / self.base_radius * self.theta_coeff
-        for mot in self._mots:
-            self._x += mot.ddist * cos(self._th + mot.rads) / count * 2 * self.x_coeff
-            self._y += mot.ddist * sin(self._th + mot.rads) / count * 2 * self.y_coeff
+            bx += mot.ddist * cos(mot.rads)
+            by += mot.ddist * sin(mot.rads)
+            dth += mot.ddist
+            mot.ddist = 0.
+        self._th += dth / count / self.base_radius * self.theta_coeff
+        bx *= 2 / count * self.x_coeff
+        by *= 2 / count * self.y_coeff
+        self._x += bx * cos(self._th) - by * sin(self._th)
+        self._y += bx * sin(self._th) + by * cos(self._th)
         return Position(self._x, self._y, self._th)
 
 def test():
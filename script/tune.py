@@ -0,0 +1,108 @@
+from dataclasses import dataclass
+from threading import Event
+from typing import Dict, List, Optional
+from .gen import MsgCaptureArm, MsgCaptureSample, MsgPid
+
+# Must match CONTROL_HZ in firmware
+CONTROL_HZ = 200
+
+@dataclass
+class Response:
+    "Step response recorded by the firmware, speeds in mm/s"
+    dt: float
+    samples: List[MsgCaptureSample]
+    # Cut short by a Move sent while recording
+    aborted: bool = False
+
+    @property
+    def t(self): return [s.index * self.dt for s in self.samples]
+    @property
+    def target(self): return [s.targSpd for s in self.samples]
+    @property
+    def speed(self): return [s.currSpd for s in self.samples]
+    @property
+    def pwm(self): return [s.pwm for s in self.samples]
+
+@dataclass
+class Fit:
+    "First order plus dead time: speed = gain * target * (1 - exp(-(t - delay) / tau))"
+    gain: float
+    tau: float
+    delay: float
+    overshoot: float
+    rise: float
+
+def set_pid(arduino, motor: int, p: float, i: float, d: float):
+    arduino.send(MsgPid(motor, round(p * 1000), round(i * 1000), round(d * 1000)))
+
+def capture(arduino, motor: int, speed_mm: int, samples: int = 128,
+            decimation: int = 1, timeout: float = 5., hz: int = CONTROL_HZ) -> Response:
+    """Arm a step to speed_mm on motor and wait for the recorded samples.
+    The motor is stopped by firmware once the capture is full. Firmware caps
+    samples to its buffer (CAPTURE_SAMPLES) and reports how many it recorded"""
+    got: Dict[int, MsgCaptureSample] = {}
+    count = samples
+    done = Event()
+    def on_sample(msg: MsgCaptureSample):
+        nonlocal count
+        count = msg.count
+        got[msg.index] = msg
+        if msg.index == msg.count - 1:
+            done.set()
+    prev = arduino.off(MsgCaptureSample)
+    arduino.on(MsgCaptureSample)(on_sample)
+    try:
+        arduino.send(MsgCaptureArm(motor, decimation, speed_mm, samples))
+        if not done.wait(timeout):
+            raise TimeoutError(f"Capture: got {len(got)}/{count} samples")
+    finally:
+        arduino.off(MsgCaptureSample)
+        if prev is not None:
+            arduino.on(MsgCaptureSample)(prev)
+    ordered = [got[i] for i in sorted(got)]
+    return Response(decimation / hz, ordered, any(s.aborted for s in ordered))
+
+def fit_first_order(resp: Response) -> Fit:
+    "Two-point (28%/63%) fit of a first order plus dead time model"
+    t, y = resp.t, resp.speed
+    if not y or not resp.target[0]:
+        raise ValueError("Empty capture or zero step")
+    step = resp.target[0]
+    tail = y[-max(1, len(y) // 5):]
+    final = sum(tail) / len(tail)
+    def crossing(frac):
+        level = final * frac
+        for i in range(1, len(y)):
+            if (y[i] - level) * (y[i - 1] - level) <= 0 and y[i] != y[i - 1]:
+                return t[i - 1] + (level - y[i - 1]) / (y[i] - y[i - 1]) * (t[i] - t[i - 1])
+        return t[-1]
+    t28, t63 = crossing(0.283), crossing(0.632)
+    tau = 1.5 * (t63 - t28)
+    peak = max(y, key=abs)
+    return Fit(
+        gain=final / step,
+        tau=tau,
+        delay=max(0., t63 - tau),
+        overshoot=max(0., peak / final - 1) if final else 0.,
+        rise=crossing(0.9) - crossing(0.1),
+    )
+
+def plot(resp: Response, fit: Optional[Fit] = None, show: bool = True):
+    import matplotlib.pyplot as plt
+    from math import exp
+    fig, (ax, axp) = plt.subplots(2, 1, sharex=True)
+    ax.plot(resp.t, resp.target, label="target")
+    ax.plot(resp.t, resp.speed, label="speed")
+    if fit:
+        step = resp.target[0]
+        model = [fit.gain * step * (1 - exp(-(x - fit.delay) / fit.tau)) if x > fit.delay and fit.tau > 0 else 0.
+                 for x in resp.t]
+        ax.plot(resp.t, model, "--", label=f"fit K={fit.gain:.2f} tau={fit.tau:.3f}s")
+    ax.set_ylabel("mm/s")
+    ax.legend()
+    axp.plot(resp.t, resp.pwm)
+    axp.set_ylabel("pwm")
+    axp.set_xlabel("s")
+    if show:
+        plt.show()
+    return fig
@@ -1,19 +1,33 @@
 #include <Python.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 #include <fmt/format.h>
 #include <atomic>
-#include <thread>
+#include <future>
+#include <mutex>
 #include <memory>
+#include <unordered_set>
 #include <map>
 #include <string>
 #include <vector>
 #include <string_view>
+#include <optional>
 #include <charconv>
+#include <cstring>
 #include <filesystem>
 #include <describe/describe.hpp>
 #include <boost/asio/serial_port.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/write.hpp>
 #include <boost/endian.hpp>
+#include <sys/eventfd.h>
+#include <unistd.h>
 #include "uri.hpp"
+#include "reactor.hpp"
+#include "odom.hpp"
+#include "gen/MsgOdom.h"
+#include "gen/MsgOdomAll.h"
 
 namespace py = pybind11;
 namespace asio = boost::asio;
@@ -24,6 +38,107 @@ namespace arduino {
 enum Flags : uint16_t {
     Request = 1,
     Ack = Request,
+    // Legacy-header negotiation of compact headers
+    Compact = 2,
+    // Back to legacy headers, see Header::Reset()
+    Reset = 4,
+};
+
+// Mirrors FrameHeader in firmware/Slip.hpp
+// Legacy: u32 id, u16 type, u16 flags (little endian, 8 bytes).
+// Compact: [more:1 | req:1 | type:6] [type >> 6 varint, if more] [id varint, if req]
+struct Header {
+    static constexpr size_t MaxSize = 8;
+
+    uint32_t id = 0;
+    uint16_t type = 0;
+    uint16_t flags = 0;
+
+    size_t parse(bool compact, string_view msg) {
+        auto p = reinterpret_cast<const uint8_t*>(msg.data());
+        if (!compact) {
+            if (msg.size() < 8) {
+                throw Err("Msg is too small: {} < 8", msg.size());
+            }
+            id = boost::endian::load_little_u32(p);
+            type = boost::endian::load_little_u16(p + 4);
+            flags = boost::endian::load_little_u16(p + 6);
+            return 8;
+        }
+        if (msg.empty()) {
+            throw Err("Empty msg");
+        }
+        size_t pos = 1;
+        auto varint = [&]{
+            uint32_t res = 0;
+            for (unsigned shift = 0; shift < 32; shift += 7) {
+                if (pos >= msg.size()) {
+                    throw Err("Truncated compact header");
+                }
+                auto b = p[pos++];
+                res |= uint32_t(b & 0x7F) << shift;
+                if (!(b & 0x80)) {
+                    return res;
+                }
+            }
+            throw Err("Invalid varint in compact header");
+        };
+        type = p[0] & 0x3F;
+        flags = p[0] & 0x40 ? Request : 0;
+        id = 0;
+        if (p[0] & 0x80) {
+            auto rest = varint();
+            if (rest > (0xFFFF >> 6)) {
+                throw Err("Type is too big: {}", rest);
+            }
+            type |= uint16_t(rest << 6);
+        }
+        if (flags & Request) {
+            id = varint();
+        }
+        return pos;
+    }
+
+    size_t dump(bool compact, char* out) const {
+        if (!compact) {
+            boost::endian::store_little_u32(reinterpret_cast<uint8_t*>(out), id);
+            boost::endian::store_little_u16(reinterpret_cast<uint8_t*>(out) + 4, type);
+            boost::endian::store_little_u16(reinterpret_cast<uint8_t*>(out) + 6, flags);
+            return 8;
+        }
+        size_t pos = 1;
+        auto varint = [&](uint32_t val) {
+            while (val > 0x7F) {
+                out[pos++] = char((val & 0x7F) | 0x80);
+                val >>= 7;
+            }
+            out[pos++] = char(val);
+        };
+        out[0] = char((type & 0x3F) | (flags & Request ? 0x40 : 0) | (type > 0x3F ? 0x80 : 0));
+        if (type > 0x3F) {
+            varint(type >> 6);
+        }
+        if (flags & Request) {
+            varint(id);
+        }
+        return pos;
+    }
+
+    // Sent by the firmware on boot with a legacy header. Read as compact it
+    // is a type 0 frame without Request, which compact mode never carries.
+    static bool isAnnounce(string_view msg) {
+        char head[MaxSize];
+        auto size = Header{0, 0, Compact}.dump(false, head);
+        return msg == string_view{head, size};
+    }
+
+    // Sent by the host on connect, the firmware takes it in both modes and
+    // goes back to legacy headers. Same reasoning as isAnnounce().
+    static string_view Reset() {
+        static char head[MaxSize];
+        static auto size = Header{0, 0, Flags::Reset}.dump(false, head);
+        return {head, size};
+    }
 };
 
 struct SLIP {
@@ -35,69 +150,193 @@ struct SLIP {
 
 
 struct Channel {
-    asio::io_context io;
+    std::shared_ptr<Reactor> reactor;
     asio::serial_port port;
-    std::thread thread;
-    uint32_t idgen = 0;
+    // Resends the compact negotiation until acked: the firmware misses it
+    // while still booting after the port opened
+    asio::steady_timer retry;
+    std::promise<void> retryStopped;
+    bool wantCompact = false;
+    // Then stays legacy: the firmware may not know compact headers at all
+    static constexpr unsigned MaxRetries = 25;
+    unsigned retries = 0;
+    std::promise<void> readStopped;
+    std::atomic<bool> closing = false;
+    std::atomic<uint32_t> idgen = 0;
     std::unordered_map<uint32_t, py::function> cbs;
+    // Header format per direction, see Flags::Compact. Guarded by sendmtx
+    std::optional<uint32_t> negotiation;
+    bool compactRx = false;
+    bool compactTx = false;
+    std::mutex sendmtx;
+    // Odometry consumed on the io thread, without python
+    std::shared_ptr<Odometry> odom;
+    bool forwardOdom = false;
     string rawbuffer = string(1024, '\0');
     string buffer;
     string sendbuff;
     bool esc = false;
     bool err = false;
+    // Queued mode: frames and acks are stashed for the owner thread instead of
+    // calling into python from the io thread. evfd is readable while non-empty.
+    bool queued = false;
+    int evfd = -1;
+    std::mutex qmtx;
+    vector<std::pair<uint16_t, string>> inbox;
+    std::atomic<uint64_t> malformed = 0;
+    vector<uint32_t> acked;
+    std::unordered_set<uint32_t> pending;
 
     virtual ~Channel() {
-        io.stop();
-        if (thread.joinable()) {
-            thread.join();
+        stop();
+        if (evfd != -1) {
+            ::close(evfd);
         }
     }
 
-    Channel(string rawuri) : io(1), port(io) {
+    // Reactor may be shared: close the port and wait for the read loop to exit
+    void stop() {
+        if (closing.exchange(true)) {
+            return;
+        }
+        auto done = readStopped.get_future();
+        std::future<void> retrying;
+        if (wantCompact) {
+            retrying = retryStopped.get_future();
+        }
+        asio::post(port.get_executor(), [this]{
+            boost::system::error_code ec;
+            port.close(ec);
+            retry.cancel();
+        });
+        auto wait = [&]{
+            done.wait();
+            if (retrying.valid()) {
+                retrying.wait();
+            }
+        };
+        if (PyGILState_Check()) {
+            py::gil_scoped_release unlock;
+            wait();
+        } else {
+            wait();
+        }
+    }
+
+    Channel(string rawuri, bool queued = false, std::shared_ptr<Reactor> shared = nullptr) :
+        reactor(shared ? std::move(shared) : std::make_shared<Reactor>(1)),
+        port(reactor->io),
+        retry(reactor->io),
+        queued(queued)
+    {
         auto uri = Uri::Parse(rawuri);
         if (uri.scheme != "serial") {
             throw Err("Unsupported protocol: {}", uri.scheme);
         }
-        using opts = asio::serial_port_base;
+        // Every param is parsed before anything can outlive a throw
+        auto baud = asio::serial_port_base::baud_rate{uri.GetOr("baud", 115200u)};
+        wantCompact = uri.GetOr("compact", 0);
         boost::system::error_code ec;
         port.open(uri.path, ec);
         if (ec) {
             throw Err("Could not open: {} => {}", rawuri, ec.message());
         }
-        auto baud = opts::baud_rate{uri.GetOr("baud", 115200u)};
         port.set_option(baud, ec);
         if (ec) {
             throw Err("Could set baudrate of {}: {}", baud.value(), ec.message());
         }
+        // Firmware may still be in compact mode from a previous session
+        {
+            std::lock_guard lock(sendmtx);
+            sendbuff.assign(1, SLIP::END);
+            escape(Header::Reset());
+            sendbuff += SLIP::END;
+            asio::write(port, asio::buffer(sendbuff), ec);
+        }
+        if (ec) {
+            throw Err("Could not write to {}: {}", rawuri, ec.message());
+        }
+        if (queued) {
+            evfd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (evfd == -1) {
+                throw Err("Could not create eventfd: {}", strerror(errno));
+            }
+        }
         startRead();
-        thread = std::thread([this]{
-            boost::system::error_code ec;
-            io.run(ec);
-            if (ec) {
-                py::gil_scoped_acquire lock;
-                error("Could not run io: " + ec.message());
+        if (wantCompact) {
+            asio::post(port.get_executor(), [this]{
+                negotiate();
+                startRetry();
+            });
+        }
+    }
+    void startRetry() {
+        retry.expires_after(std::chrono::milliseconds(200));
+        retry.async_wait([this](boost::system::error_code const& ec){
+            if (ec || closing) {
+                retryStopped.set_value();
+                return;
             }
+            bool pending, gaveUp = false;
+            {
+                std::lock_guard lock(sendmtx);
+                pending = negotiation.has_value();
+                if (pending && ++retries > MaxRetries) {
+                    negotiation.reset();
+                    pending = false;
+                    gaveUp = true;
+                }
+            }
+            if (pending) {
+                negotiate(true);
+            } else if (gaveUp) {
+                py::gil_scoped_acquire gil;
+                error("Compact headers were not acked, staying on legacy headers");
+            }
+            startRetry();
         });
     }
     void startRead() {
         port.async_read_some(asio::buffer(rawbuffer.data(), rawbuffer.size()), [this](auto& ec, auto sz){
-            readDone(ec, sz);
-            startRead();
+            if (ec && (closing || ec == asio::error::operation_aborted)) {
+                readStopped.set_value();
+                return;
+            }
+            if (readDone(ec, sz)) {
+                startRead();
+            } else {
+                readStopped.set_value();
+            }
         });
     }
 
     void handleMsg(string_view msg) {
-        if (msg.size() < 8) {
-            throw Err("Msg is too small: {} < 8", msg.size());
+        if (Header::isAnnounce(msg)) {
+            if (wantCompact && compactRx) {
+                // Firmware was reset and talks legacy again
+                compactRx = false;
+                negotiate();
+            }
+            return;
+        }
+        Header header;
+        auto hsize = header.parse(compactRx, msg);
+        auto [id, type, flags] = header;
+        auto body = msg.substr(hsize);
+        if ((flags & Ack) && wantCompact && acceptNegotiation(id, flags)) {
+            return;
+        }
+        if (!(flags & Ack) && handleOdom(type, body) && !forwardOdom) {
+            return;
+        }
+        if (queued) {
+            enqueue(id, type, flags, body);
+            return;
         }
-        auto p = reinterpret_cast<const uint8_t*>(msg.data());
-        auto id = boost::endian::load_little_u32(p);
-        auto type = boost::endian::load_little_u16(p + 4);
-        auto flags = boost::endian::load_little_u16(p + 6);
         if (!PyGILState_Check()) {
             py::gil_scoped_acquire lock;
             if (flags & Ack) {
-                if (msg.size() != 8) {
+                if (body.size()) {
                     throw Err("Received ACK which is too long: {}", msg.size());
                 }
                 if (auto it = cbs.find(id); it != cbs.end()) {
@@ -105,18 +344,205 @@ struct Channel {
                     cbs.erase(it);
                 }
             } else {
-                _onmessage(type, py::bytes(msg.substr(8)));
+                _onmessage(type, py::bytes(body));
             }
         }
     }
 
-    void readDone(boost::system::error_code const& ec, size_t amount) try {
+    bool handleOdom(uint16_t type, string_view body) {
+        auto current = std::atomic_load(&odom);
+        if (!current) {
+            return false;
+        }
+        switch (type) {
+        case MsgOdom_Type: {
+            MsgOdom msg;
+            if (!parse_MsgOdom(&msg, body.data(), body.size())) {
+                throw Err("Invalid MsgOdom size: {}", body.size());
+            }
+            current->HandleMotor(size_t(msg.num), msg.ddist_mm / 1000.);
+            return true;
+        }
+        case MsgOdomAll_Type: {
+            MsgOdomAll msg;
+            if (!parse_MsgOdomAll(&msg, body.data(), body.size())) {
+                throw Err("Invalid MsgOdomAll size: {}", body.size());
+            }
+            double ddists[] = {msg.ddist0_mm / 1000., msg.ddist1_mm / 1000., msg.ddist2_mm / 1000.};
+            current->HandleAll(ddists, std::size(ddists), msg.micros, msg.seq);
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+    void attach_odometry(std::shared_ptr<Odometry> target, bool forward) {
+        forwardOdom = forward;
+        std::atomic_store(&odom, std::move(target));
+    }
+
+    // Legacy request with a fresh id, runs on the io thread. Our tx goes back
+    // to legacy until the firmware acks it.
+    void negotiate(bool retry = false) {
+        boost::system::error_code ec;
+        {
+            std::lock_guard lock(sendmtx);
+            if (!retry) {
+                retries = 0;
+            }
+            compactTx = false;
+            negotiation = idgen++;
+            write(0, {}, Request | Compact, *negotiation, ec);
+        }
+        if (ec) {
+            py::gil_scoped_acquire gil;
+            error(ec.message());
+        }
+    }
+
+    // On the ack of the latest request sends the last legacy frame, the
+    // firmware switches its rx once it sees it
+    bool acceptNegotiation(uint32_t id, uint16_t flags) {
+        boost::system::error_code ec;
+        {
+            std::lock_guard lock(sendmtx);
+            if (id != negotiation) {
+                return false;
+            }
+            negotiation.reset();
+            if (!(flags & Compact)) {
+                return true;
+            }
+            // Firmware switched its tx right after this ack
+            compactRx = true;
+            write(0, {}, Compact, 0, ec);
+            compactTx = true;
+        }
+        if (ec) {
+            py::gil_scoped_acquire gil;
+            error(ec.message());
+        }
+        return true;
+    }
+
+    void enqueue(uint32_t id, uint16_t type, uint16_t flags, string_view body) {
+        std::lock_guard lock(qmtx);
+        bool wasEmpty = inbox.empty() && acked.empty();
+        if (flags & Ack) {
+            if (pending.erase(id)) {
+                acked.push_back(id);
+            }
+        } else {
+            inbox.emplace_back(type, string{body});
+        }
+        // Only the empty -> non-empty edge wakes the reader
+        if (wasEmpty && !(inbox.empty() && acked.empty())) {
+            uint64_t one = 1;
+            (void)::write(evfd, &one, sizeof(one));
+        }
+    }
+
+    // Must be called with qmtx held
+    void resetEvent() {
+        if (inbox.empty() && acked.empty()) {
+            uint64_t count;
+            (void)::read(evfd, &count, sizeof(count));
+        }
+    }
+
+    void checkQueued() {
+        if (!queued) {
+            throw Err("Channel was not created with queued=True");
+        }
+    }
+
+    int fileno() {
+        checkQueued();
+        return evfd;
+    }
+
+    py::list recv_batch() {
+        checkQueued();
+        vector<std::pair<uint16_t, string>> frames;
+        {
+            std::lock_guard lock(qmtx);
+            frames.swap(inbox);
+            resetEvent();
+        }
+        py::list res(frames.size());
+        for (size_t i = 0; i < frames.size(); ++i) {
+            res[i] = py::make_tuple(frames[i].first, py::bytes(frames[i].second));
+        }
+        return res;
+    }
+
+    // Bodies concatenated per type in arrival order, so fixed-size messages
+    // decode with one Msg.from_buffer_batch() call per type. A frame of the
+    // wrong size would shift every later record, so only frames of exactly
+    // sizes[type] bytes are joined, the rest are counted as malformed.
+    py::dict recv_grouped(std::map<uint16_t, size_t> const& sizes) {
+        checkQueued();
+        vector<std::pair<uint16_t, string>> frames;
+        {
+            std::lock_guard lock(qmtx);
+            frames.swap(inbox);
+            resetEvent();
+        }
+        std::map<uint16_t, string> groups;
+        for (auto& [type, body]: frames) {
+            if (auto it = sizes.find(type); it == sizes.end() || it->second != body.size()) {
+                malformed.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            groups[type] += body;
+        }
+        py::dict res;
+        for (auto& [type, bodies]: groups) {
+            res[py::int_(type)] = py::bytes(bodies);
+        }
+        return res;
+    }
+
+    py::list recv_acks() {
+        checkQueued();
+        vector<uint32_t> ids;
+        {
+            std::lock_guard lock(qmtx);
+            ids.swap(acked);
+            resetEvent();
+        }
+        py::list res(ids.size());
+        for (size_t i = 0; i < ids.size(); ++i) {
+            res[i] = ids[i];
+        }
+        return res;
+    }
+
+    uint32_t send_request(int type, py::bytes body) {
+        checkQueued();
+        auto id = idgen++;
+        {
+            std::lock_guard lock(qmtx);
+            pending.insert(id);
+        }
+        doSend(type, string_view{body}, Request, id);
+        return id;
+    }
+
+    void forget(uint32_t id) {
+        std::lock_guard lock(qmtx);
+        pending.erase(id);
+    }
+
+    // Returns false if reading should stop
+    bool readDone(boost::system::error_code const& ec, size_t amount) try {
         if (ec) {
             if (!PyGILState_Check()) {
                 py::gil_scoped_acquire lock;
                 error(ec.message());
-                return;
             }
+            return false;
         }
         auto recv = string_view{rawbuffer.data(), amount};
         for (auto ch: recv) {
@@ -156,42 +582,56 @@ struct Channel {
                 buffer += ch;
             }
         }
+        return true;
     } catch (std::exception& e) {
-        startRead();
+        buffer.clear();
         if (!PyGILState_Check()) {
             py::gil_scoped_acquire lock;
             error(e.what());
         }
+        return true;
     }
 
     void send(int type, py::bytes body) {
-        doSend(type, body, std::nullopt, idgen++);
+        doSend(type, string_view{body}, 0, idgen++);
     }
 
     void send_with_ack(int type, py::bytes body, py::function ack) {
-        doSend(type, body, std::move(ack), idgen++);
+        auto id = idgen++;
+        auto [iter, ok] = cbs.try_emplace(id, ack);
+        if (!ok) {
+            iter->second(std::runtime_error("Timeout"));
+            iter->second = std::move(ack);
+        }
+        doSend(type, string_view{body}, Request, id);
+    }
+
+    void doSend(int type, string_view body, uint16_t flags, uint32_t id) {
+        boost::system::error_code ec;
+        {
+            std::lock_guard lock(sendmtx);
+            write(type, body, flags, id, ec);
+        }
+        // error() may be overridden to send again
+        if (ec) {
+            error(ec.message());
+        }
     }
 
-    void doSend(int type, py::bytes body, std::optional<py::function> ack, uint32_t id) {
-        uint16_t flags = 0;
-        auto orig = string_view{body};
+    // Must be called with sendmtx held
+    void write(int type, string_view body, uint16_t flags, uint32_t id, boost::system::error_code& ec) {
+        char head[Header::MaxSize];
+        auto hsize = Header{id, uint16_t(type), flags}.dump(compactTx, head);
         sendbuff.clear();
-        sendbuff.reserve(orig.size() + 10);
-        sendbuff.resize(8);
-        if (auto& f = ack) {
-            flags |= Request;
-            auto [iter, ok] = cbs.try_emplace(id, std::move(*f));
-            if (!ok) {
-                iter->second(std::runtime_error("Timeout"));
-                iter->second = std::move(*f);
-            }
+        sendbuff.reserve((hsize + body.size()) * 2 + 1);
+        for (auto part: {string_view{head, hsize}, body}) {
+            escape(part);
         }
-        auto lid = boost::endian::native_to_little(id);
-        auto ltype = boost::endian::native_to_little(uint16_t(type));
-        auto lflags = boost::endian::native_to_little(uint16_t(flags));
-        memcpy(sendbuff.data(), &lid, 4);
-        memcpy(sendbuff.data() + 4, &ltype, 2);
-        memcpy(sendbuff.data() + 6, &lflags, 2);
+        sendbuff += SLIP::END;
+        asio::write(port, asio::buffer(sendbuff), ec);
+    }
+
+    void escape(string_view orig) {
         for (auto ch: orig) {
             switch (ch) {
             case SLIP::END: {
@@ -209,12 +649,6 @@ struct Channel {
             }
             }
         }
-        sendbuff += SLIP::END;
-        boost::system::error_code ec;
-        port.write_some(asio::buffer(sendbuff), ec);
-        if (ec) {
-            error(ec.message());
-        }
     }
 
     virtual void _onmessage(int type, py::bytes body) = 0;
@@ -238,6 +672,7 @@ struct PyChannel : Channel {
         PYBIND11_OVERRIDE(void, Channel, log, msg);
     }
     ~PyChannel() {
+        stop();
         if (!PyGILState_Check()) {
             py::gil_scoped_acquire lock;
             cbs.clear();
@@ -251,9 +686,49 @@ struct PyChannel : Channel {
 
 using namespace py::literals;
 
+static py::tuple poseTuple(Pose const& p) {
+    return py::make_tuple(p.t, p.x, p.y, p.th);
+}
+
 PYBIND11_MODULE(arduino, m) {
+    py::class_<Odometry, std::shared_ptr<Odometry>>(m, "Odometry")
+        .def(py::init([](vector<double> angles, double baseRadius, double thetaCoeff,
+                         double xCoeff, double yCoeff, double wheelNoise, size_t history) {
+                 Odometry::Params params;
+                 params.baseRadius = baseRadius;
+                 params.thetaCoeff = thetaCoeff;
+                 params.xCoeff = xCoeff;
+                 params.yCoeff = yCoeff;
+                 params.wheelNoise = wheelNoise;
+                 return std::make_shared<Odometry>(std::move(angles), params, history);
+             }),
+             "Native odometry for motors at angles (degrees), attach with Channel.attach_odometry()",
+             "angles"_a, "base_radius"_a = 0.15, "theta_coeff"_a = 1., "x_coeff"_a = 1.,
+             "y_coeff"_a = 1., "wheel_noise"_a = 0., "history"_a = 256)
+        .def("pose", [](Odometry& o){ return poseTuple(o.Current()); },
+             "Latest pose as tuple[t, x, y, theta]")
+        .def("covariance", &Odometry::Covariance,
+             "Row-major 3x3 covariance of (x, y, theta), zeros if wheel_noise is 0")
+        .def("history", [](Odometry& o){
+                 auto hist = o.History();
+                 py::list res(hist.size());
+                 for (size_t i = 0; i < hist.size(); ++i) {
+                     res[i] = poseTuple(hist[i]);
+                 }
+                 return res;
+             },
+             "Last poses, oldest first, as list[tuple[t, x, y, theta]]")
+        .def("reset", &Odometry::Reset,
+             "Reset pose and covariance",
+             "x"_a = 0., "y"_a = 0., "theta"_a = 0.)
+        .def_property_readonly("dropped", &Odometry::Dropped,
+             "MsgOdomAll frames lost, detected from sequence gaps")
+        .def_property_readonly("hits", &Odometry::Hits,
+             "Integrated updates");
     py::class_<arduino::Channel, arduino::PyChannel>(m, "Channel")
-        .def(py::init<string>(), "Create comms Channel with device on uri")
+        .def(py::init<string, bool, std::shared_ptr<bang::Reactor>>(),
+             "Create comms Channel with device on uri, optionally running on shared reactor",
+             "uri"_a, "queued"_a = false, "reactor"_a = nullptr)
         .def("_onmessage", &arduino::Channel::_onmessage,
              "Override to handle incoming packets",
              "type"_a, "body"_a)
@@ -268,5 +743,28 @@ PYBIND11_MODULE(arduino, m) {
              "type"_a, "body"_a)
         .def("send_with_ack", &arduino::Channel::send_with_ack,
              "Send packet with ack callback",
-             "type"_a, "body"_a, "ack"_a);
+             "type"_a, "body"_a, "ack"_a)
+        .def("fileno", &arduino::Channel::fileno,
+             "Eventfd, readable while queued frames or acks are pending (queued mode)")
+        .def("recv_batch", &arduino::Channel::recv_batch,
+             "Drain queued frames as list[tuple[type, body]] (queued mode)")
+        .def("recv_grouped", &arduino::Channel::recv_grouped,
+             "Drain queued frames as dict[type, bytes] of concatenated bodies (queued mode). "
+             "Frames of types missing from sizes (dict[type, payload size]) or of another size are dropped",
+             "sizes"_a)
+        .def_property_readonly("malformed", [](arduino::Channel& chan){
+                 return chan.malformed.load(std::memory_order_relaxed);
+             },
+             "Frames dropped by recv_grouped for their type or size")
+        .def("recv_acks", &arduino::Channel::recv_acks,
+             "Drain ids of acknowledged requests (queued mode)")
+        .def("send_request", &arduino::Channel::send_request,
+             "Send packet requesting ack, returns id reported by recv_acks (queued mode)",
+             "type"_a, "body"_a)
+        .def("forget", &arduino::Channel::forget,
+             "Stop waiting for ack of request id",
+             "id"_a)
+        .def("attach_odometry", &arduino::Channel::attach_odometry,
+             "Integrate MsgOdom/MsgOdomAll on the io thread, forward=True still delivers them to python",
+             "odom"_a, "forward"_a = false);
 }
@@ -1,14 +1,36 @@
 #include <Python.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
 #include <atomic>
+#include <future>
 #include <thread>
 #include <memory>
 #include <map>
+#include <mutex>
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <vector>
 #include <string_view>
+#include <optional>
+#include <random>
+#include <array>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/post.hpp>
 #include "sl_lidar.h"
 #include "uri.hpp"
+#include "reactor.hpp"
+#include "scan.hpp"
+#include "icp.hpp"
+#include "grid.hpp"
+#include "mcl.hpp"
+#include "cluster.hpp"
+#include "lines.hpp"
+#include "landmarks.hpp"
+#include "filter.hpp"
+#include "temporal.hpp"
+#include "downsample.hpp"
 
 using namespace bang;
 namespace py = pybind11;
@@ -136,12 +158,6 @@ static void initMode(sl::ILidarDriver& driver, string_view wanted) {
     throw Err("Could not initialize mode: {}, all: [{}]", wanted, all);
 }
 
-struct ParsedNode {
-    float range{};
-    float intensity{};
-    float relTheta{};
-};
-
 static constexpr float toRadians(float degrees) noexcept
 {
     return (degrees * 6.283f / 360.f);
@@ -153,10 +169,24 @@ struct Driver {
     LidarInfo info;
     std::unique_ptr<sl::ILidarDriver> driver;
     std::unique_ptr<sl::IChannel> chan;
+    std::vector<sl_lidar_response_measurement_node_hq_t> nodes = decltype(nodes)(8192);
+    std::vector<ParsedNode> parsed = decltype(parsed)(8192);
+    SinkList sinks;
+    std::shared_ptr<const ScanFilter> filter;
+    // View of the scan passed to _onscan, sinks see the full scan
+    std::shared_ptr<const Downsampler> pyView;
+    std::vector<uint32_t> pyIndex;
     int rpm = 600;
+    // When attached to a shared reactor scans are polled from a timer
+    // instead of blocking a dedicated thread
+    std::shared_ptr<Reactor> reactor;
+    std::unique_ptr<asio::steady_timer> timer;
+    std::chrono::milliseconds pollPeriod{10};
+    std::promise<void> pollStopped;
 
-    Driver(string rawuri) :
-        driver(*sl::createLidarDriver())
+    Driver(string rawuri, std::shared_ptr<Reactor> shared = nullptr) :
+        driver(*sl::createLidarDriver()),
+        reactor(std::move(shared))
     {
         auto uri = Uri::Parse(rawuri);
         chan.reset(connect(uri));
@@ -164,6 +194,9 @@ struct Driver {
         if (result & SL_RESULT_FAIL_BIT) {
             throw Err("Could not connect: {}", PrintEnum(result));
         }
+        if (ScanFilter::Configured(uri.params)) {
+            setFilter(ScanFilter::Parse(uri.params));
+        }
         info = getInfo(*driver);
         checkHealth(*driver);
         initMode(*driver, GetOr(uri.params, "mode", string{"DenseBoost"}));
@@ -171,39 +204,155 @@ struct Driver {
         if (!info.needsTune) {
             driver->setMotorSpeed(rpm);
         }
-        thread = std::thread(&Driver::spin, this);
+        if (reactor) {
+            pollPeriod = std::chrono::milliseconds(GetOr(uri.params, "poll_ms", 10));
+            timer = std::make_unique<asio::steady_timer>(reactor->io);
+            startPoll();
+        } else {
+            thread = std::thread(&Driver::spin, this);
+        }
     }
-    void runCb(sl_lidar_response_measurement_node_hq_t* nodes, size_t count) {
-        py::gil_scoped_acquire lock;
-        py::tuple result(count);
+    void fill(size_t i, ParsedNode& node) const noexcept {
+        node.range = static_cast<float>(nodes[i].dist_mm_q2/4000.f);
+        node.intensity = static_cast<float>(nodes[i].quality >> SL_LIDAR_RESP_MEASUREMENT_QUALITY_SHIFT);
+        node.relTheta = toRadians(nodes[i].angle_z_q14 * 90.f / 16384.f);
+    }
+    // Filtered nodes are compacted in place, returns how many survived
+    size_t convert(size_t count) {
+        auto current = std::atomic_load(&filter);
+        size_t kept = 0;
+        size_t cursor = 0;
+        if (current && current->Shadows()) {
+            // Shadows need the unfiltered neighbours of every node, the
+            // filter keeps them until compared
+            current->DropShadows(count, [&](size_t i, ParsedNode& node){
+                fill(i, node);
+                node.x = node.range * std::cos(node.relTheta);
+                node.y = -node.range * std::sin(node.relTheta);
+            }, [&](ParsedNode const& node){
+                if (current->Polar(node, cursor) && current->Cartesian(node)) {
+                    parsed[kept++] = node;
+                }
+            });
+            return kept;
+        }
         for (size_t i = 0; i < count; ++i) {
-            ParsedNode node;
-            node.range = static_cast<float>(nodes[i].dist_mm_q2/4000.f);
-            node.intensity = static_cast<float>(nodes[i].quality >> SL_LIDAR_RESP_MEASUREMENT_QUALITY_SHIFT);
-            node.relTheta = toRadians(nodes[i].angle_z_q14 * 90.f / 16384.f);
+            auto& node = parsed[kept];
+            fill(i, node);
+            if (current && !current->Polar(node, cursor)) {
+                continue;
+            }
+            node.x = node.range * std::cos(node.relTheta);
+            node.y = -node.range * std::sin(node.relTheta);
+            if (current && !current->Cartesian(node)) {
+                continue;
+            }
+            kept++;
+        }
+        return kept;
+    }
+    void setFilter(ScanFilter::Params params) {
+        std::atomic_store(&filter, std::make_shared<const ScanFilter>(std::move(params)));
+    }
+    void clearFilter() {
+        std::atomic_store(&filter, std::shared_ptr<const ScanFilter>());
+    }
+    void runSinks(Scan const& scan) {
+        sinks.Run(scan, [this](std::exception& e){
+            py::gil_scoped_acquire lock;
+            error(fmt::format("ScanSink: {}", e.what()));
+        });
+    }
+    void attach(std::shared_ptr<ScanSink> sink) {
+        sinks.Attach(std::move(sink));
+    }
+    void detach(std::shared_ptr<ScanSink> sink) {
+        sinks.Detach(sink);
+    }
+    void setDownsample(Downsampler::Params params) {
+        std::atomic_store(&pyView, std::make_shared<const Downsampler>(params));
+    }
+    void clearDownsample() {
+        std::atomic_store(&pyView, std::shared_ptr<const Downsampler>());
+    }
+    void runCb(Scan const& full) {
+        auto scan = full;
+        if (auto view = std::atomic_load(&pyView)) {
+            view->Select(full, pyIndex);
+            scan.index = pyIndex.data();
+            scan.count = pyIndex.size();
+        }
+        py::gil_scoped_acquire lock;
+        py::tuple result(scan.size());
+        for (size_t i = 0; i < scan.size(); ++i) {
+            auto& node = scan[i];
             result[i] = py::make_tuple(node.range, node.intensity, node.relTheta);
         }
         _onscan(result);
     }
+    // Returns false if no scan was ready within timeout
+    bool step(sl_u32 timeout) {
+        size_t count = nodes.size();
+        if (auto err = Results(driver->grabScanDataHq(nodes.data(), count, timeout)); err & SL_RESULT_FAIL_BIT) {
+            if (!timeout && err == ResultOperationTimeout) {
+                return false;
+            }
+            py::gil_scoped_acquire lock;
+            error(fmt::format("GrabScan: {}", PrintEnum(err)));
+            return true;
+        }
+        if (std::exchange(info.needsTune, false)) {
+            driver->setMotorSpeed(rpm);
+            return true;
+        }
+        if (auto err = Results(driver->ascendScanData(nodes.data(), count)); err & SL_RESULT_FAIL_BIT) {
+            py::gil_scoped_acquire lock;
+            error(fmt::format("AscendScan: {}", PrintEnum(err)));
+            return true;
+        }
+        Scan scan{parsed.data(), convert(count), Scan::Now()};
+        runSinks(scan);
+        runCb(scan);
+        return true;
+    }
     void spin() {
-        size_t count = 8192UL;
-        std::vector<sl_lidar_response_measurement_node_hq_t> nodes(count);
         while (!shutdown.load(std::memory_order_relaxed)) {
-            if (auto err = Results(driver->grabScanDataHq(nodes.data(), count)); err & SL_RESULT_FAIL_BIT) {
-                py::gil_scoped_acquire lock;
-                error(fmt::format("AscendScan: {}", PrintEnum(err)));
-                continue;
-            }
-            if (std::exchange(info.needsTune, false)) {
-                driver->setMotorSpeed(rpm);
-                continue;
-            }
-            if (auto err = Results(driver->ascendScanData(nodes.data(), count)); err & SL_RESULT_FAIL_BIT) {
-                py::gil_scoped_acquire lock;
-                error(fmt::format("AscendScan: {}", PrintEnum(err)));
-                continue;
+            step(sl::ILidarDriver::DEFAULT_TIMEOUT);
+        }
+    }
+    void startPoll() {
+        timer->expires_after(pollPeriod);
+        timer->async_wait([this](boost::system::error_code const&){
+            if (shutdown.load(std::memory_order_relaxed)) {
+                pollStopped.set_value();
+                return;
             }
-            runCb(nodes.data(), count);
+            step(0);
+            startPoll();
+        });
+    }
+
+    void stop() {
+        if (shutdown.exchange(true)) {
+            return;
+        }
+        std::future<void> polling;
+        if (timer) {
+            polling = pollStopped.get_future();
+            asio::post(timer->get_executor(), [this]{
+                timer->cancel();
+            });
+        }
+        // Scan callbacks take the GIL, let them finish
+        std::optional<py::gil_scoped_release> unlock;
+        if (PyGILState_Check()) {
+            unlock.emplace();
+        }
+        if (thread.joinable()) {
+            thread.join();
+        }
+        if (polling.valid()) {
+            polling.wait();
         }
     }
 
@@ -213,10 +362,7 @@ struct Driver {
     }
 
     virtual ~Driver() {
-        shutdown = true;
-        if (thread.joinable()) {
-            thread.join();
-        }
+        stop();
         driver.reset();
         chan.reset();
     }
@@ -224,6 +370,9 @@ struct Driver {
 
 struct PyDriver : Driver {
     using Driver::Driver;
+    ~PyDriver() {
+        stop();
+    }
 
     void _onscan(py::tuple data) override {
         PYBIND11_OVERRIDE_PURE(void, Driver, _onscan, data);
@@ -236,14 +385,529 @@ struct PyDriver : Driver {
 } //rp
 } //lidarbridge
 
+using namespace py::literals;
+
+static py::tuple poseTuple(Pose const& p) {
+    return py::make_tuple(p.t, p.x, p.y, p.th);
+}
+
 PYBIND11_MODULE(lidar, m) {
+    py::class_<ScanSink, std::shared_ptr<ScanSink>>(m, "ScanSink",
+        "Native scan consumer, runs on the driver thread, attach with RP.attach()");
+    py::class_<Icp::Match>(m, "IcpMatch")
+        .def_readonly("t", &Icp::Match::t)
+        .def_readonly("dx", &Icp::Match::dx)
+        .def_readonly("dy", &Icp::Match::dy)
+        .def_readonly("dth", &Icp::Match::dth)
+        .def_readonly("score", &Icp::Match::score)
+        .def_readonly("rmse", &Icp::Match::rmse)
+        .def_readonly("elapsed_ms", &Icp::Match::elapsedMs)
+        .def_readonly("iterations", &Icp::Match::iterations)
+        .def_readonly("matched", &Icp::Match::matched)
+        .def_readonly("ok", &Icp::Match::ok);
+    py::class_<Icp, ScanSink, std::shared_ptr<Icp>>(m, "Icp")
+        .def(py::init([](double maxDist, double cell, double minRange, int maxIterations,
+                         double epsilon, size_t minMatches, size_t stride) {
+                 Icp::Params params;
+                 params.maxDist = maxDist;
+                 params.cell = cell;
+                 params.minRange = minRange;
+                 params.maxIterations = maxIterations;
+                 params.epsilon = epsilon;
+                 params.minMatches = minMatches;
+                 params.stride = stride;
+                 return std::make_shared<Icp>(params);
+             }),
+             "Point-to-line scan-to-scan matcher",
+             "max_dist"_a = 0.3, "cell"_a = 0.05, "min_range"_a = 0.05, "max_iterations"_a = 30,
+             "epsilon"_a = 1e-4, "min_matches"_a = 30, "stride"_a = 1)
+        .def("attach_odometry", &Icp::AttachOdometry,
+             "Use arduino.Odometry as initial guess for each match",
+             "odom"_a)
+        .def("pose", [](Icp& icp){ return poseTuple(icp.Current()); },
+             "Accumulated pose as tuple[t, x, y, theta]")
+        .def("last", &Icp::Last,
+             "Latest incremental match, in the previous scan's frame")
+        .def("reset", &Icp::Reset,
+             "Reset accumulated pose",
+             "x"_a = 0., "y"_a = 0., "theta"_a = 0.)
+        .def_property_readonly("hits", &Icp::Hits,
+             "Scans consumed");
+    py::class_<OccupancyGrid, ScanSink, std::shared_ptr<OccupancyGrid>>(m, "Grid")
+        .def(py::init([](double resolution, double hit, double miss, double min, double max,
+                         double minRange, double maxRange, double mountX, double mountY,
+                         double mountTheta, unsigned sectors, std::shared_ptr<Reactor> reactor) {
+                 OccupancyGrid::Params params;
+                 params.resolution = resolution;
+                 params.hit = hit;
+                 params.miss = miss;
+                 params.min = min;
+                 params.max = max;
+                 params.minRange = minRange;
+                 params.maxRange = maxRange;
+                 params.mountX = mountX;
+                 params.mountY = mountY;
+                 params.mountTh = mountTheta;
+                 params.sectors = sectors;
+                 return std::make_shared<OccupancyGrid>(params, std::move(reactor));
+             }),
+             "Tiled log-odds occupancy grid, rays cast in parallel sectors on reactor if given",
+             "resolution"_a = 0.05, "hit"_a = 0.85, "miss"_a = -0.4, "min"_a = -2., "max"_a = 3.5,
+             "min_range"_a = 0.05, "max_range"_a = 12., "mount_x"_a = 0., "mount_y"_a = 0.,
+             "mount_theta"_a = 0., "sectors"_a = 8, "reactor"_a = nullptr)
+        .def("attach_pose", [](OccupancyGrid& grid, std::shared_ptr<Icp> icp){
+                 grid.AttachPose([icp]{ return icp->Current(); });
+             },
+             "Take robot pose for each scan from Icp",
+             "source"_a)
+        .def("attach_pose", [](OccupancyGrid& grid, std::shared_ptr<Odometry> odom){
+                 grid.AttachPose([odom]{ return odom->Current(); });
+             },
+             "Take robot pose for each scan from arduino.Odometry",
+             "source"_a)
+        .def("attach_pose", [](OccupancyGrid& grid, std::shared_ptr<Mcl> mcl){
+                 grid.AttachPose([mcl]{ return mcl->Current(); });
+             },
+             "Take robot pose for each scan from Mcl",
+             "source"_a)
+        .def("set_pose", &OccupancyGrid::SetPose,
+             "Fixed robot pose, detaches pose source",
+             "x"_a, "y"_a, "theta"_a)
+        .def("tiles", [](OccupancyGrid const& grid){
+                 py::list res;
+                 constexpr auto size = OccupancyGrid::TileSize;
+                 // Copied under the grid lock, scans keep updating cells
+                 grid.EachTile([&](OccupancyGrid::Tile const& tile){
+                     py::array_t<OccupancyGrid::Cell> copy({size, size});
+                     std::copy_n(tile.cells, size * size, copy.mutable_data());
+                     res.append(py::make_tuple(tile.tx * size, tile.ty * size, copy));
+                 });
+                 return res;
+             },
+             "Copies as list[tuple[x0, y0, int16 array[y, x]]], cells of log-odds thousandths")
+        .def("to_array", [](OccupancyGrid& grid){
+                 auto cells = std::make_unique<vector<OccupancyGrid::Cell>>();
+                 int32_t x0, y0, width, height;
+                 if (!grid.Dense(*cells, x0, y0, width, height)) {
+                     return py::make_tuple(py::none(), 0, 0);
+                 }
+                 auto data = cells->data();
+                 py::capsule owner(cells.release(), [](void* p){
+                     delete static_cast<vector<OccupancyGrid::Cell>*>(p);
+                 });
+                 py::array_t<OccupancyGrid::Cell> arr({height, width}, data, owner);
+                 return py::make_tuple(arr, x0, y0);
+             },
+             "Dense copy as tuple[int16 array[y, x], x0, y0], None if empty")
+        .def("clear", &OccupancyGrid::Clear)
+        .def_property_readonly("resolution", &OccupancyGrid::Resolution)
+        .def_property_readonly("hits", &OccupancyGrid::Hits,
+             "Scans consumed")
+        .attr("tile_size") = OccupancyGrid::TileSize;
+    py::class_<Mcl, ScanSink, std::shared_ptr<Mcl>>(m, "Mcl")
+        .def(py::init([](size_t minParticles, size_t maxParticles, size_t beams, double minRange,
+                         double maxRange, double sigmaHit, double zHit, double zRand,
+                         std::array<double, 4> alphas, double updateMinDist, double updateMinAngle,
+                         double kldErr, double kldZ, double mountX, double mountY, double mountTheta,
+                         std::shared_ptr<Reactor> reactor, std::optional<unsigned> seed) {
+                 Mcl::Params params;
+                 params.minParticles = minParticles;
+                 params.maxParticles = maxParticles;
+                 params.beams = beams;
+                 params.minRange = minRange;
+                 params.maxRange = maxRange;
+                 params.sigmaHit = sigmaHit;
+                 params.zHit = zHit;
+                 params.zRand = zRand;
+                 params.alpha1 = alphas[0];
+                 params.alpha2 = alphas[1];
+                 params.alpha3 = alphas[2];
+                 params.alpha4 = alphas[3];
+                 params.updateMinDist = updateMinDist;
+                 params.updateMinAngle = updateMinAngle;
+                 params.kldErr = kldErr;
+                 params.kldZ = kldZ;
+                 params.mountX = mountX;
+                 params.mountY = mountY;
+                 params.mountTh = mountTheta;
+                 return std::make_shared<Mcl>(params, std::move(reactor), seed.value_or(std::random_device{}()));
+             }),
+             "Particle filter localization against a map, particles scored on reactor if given",
+             "min_particles"_a = 100, "max_particles"_a = 5000, "beams"_a = 60, "min_range"_a = 0.05,
+             "max_range"_a = 12., "sigma_hit"_a = 0.2, "z_hit"_a = 0.95, "z_rand"_a = 0.05,
+             "alphas"_a = std::array<double, 4>{0.2, 0.2, 0.2, 0.2}, "update_min_dist"_a = 0.05,
+             "update_min_angle"_a = 0.05, "kld_err"_a = 0.05, "kld_z"_a = 2.33, "mount_x"_a = 0.,
+             "mount_y"_a = 0., "mount_theta"_a = 0., "reactor"_a = nullptr, "seed"_a = py::none())
+        .def("set_map", [](Mcl& mcl, py::array_t<uint8_t, py::array::c_style | py::array::forcecast> occupied,
+                           double resolution, double x0, double y0) {
+                 if (occupied.ndim() != 2) {
+                     throw Err("Mcl: map must be 2d [y, x]");
+                 }
+                 auto height = size_t(occupied.shape(0));
+                 auto width = size_t(occupied.shape(1));
+                 py::gil_scoped_release unlock;
+                 mcl.SetMap(occupied.data(), width, height, resolution, x0, y0);
+             },
+             "Map as array[y, x], nonzero is occupied, cell (0, 0) at (x0, y0) meters",
+             "occupied"_a, "resolution"_a, "x0"_a = 0., "y0"_a = 0.)
+        .def("set_map_from_grid", [](Mcl& mcl, OccupancyGrid& grid, int threshold) {
+                 py::gil_scoped_release unlock;
+                 vector<OccupancyGrid::Cell> cells;
+                 int32_t x0, y0, width, height;
+                 if (!grid.Dense(cells, x0, y0, width, height)) {
+                     throw Err("Mcl: grid is empty");
+                 }
+                 vector<uint8_t> occupied(cells.size());
+                 for (size_t i = 0; i < cells.size(); ++i) {
+                     occupied[i] = cells[i] > threshold;
+                 }
+                 auto res = grid.Resolution();
+                 mcl.SetMap(occupied.data(), size_t(width), size_t(height), res, x0 * res, y0 * res);
+             },
+             "Map from Grid cells above threshold (log-odds thousandths)",
+             "grid"_a, "threshold"_a = 0)
+        .def("reset", &Mcl::Reset,
+             "Gaussian particles around pose",
+             "x"_a, "y"_a, "theta"_a, "sigma_x"_a = 0.2, "sigma_y"_a = 0.2, "sigma_theta"_a = 0.2)
+        .def("reset_global", &Mcl::ResetGlobal,
+             "Uniform particles over free space")
+        .def("predict", &Mcl::Predict,
+             "Apply odometry delta in the robot frame",
+             "dx"_a, "dy"_a, "dtheta"_a,
+             py::call_guard<py::gil_scoped_release>())
+        .def("pose", [](Mcl& mcl){ return poseTuple(mcl.Current()); },
+             "Weighted mean as tuple[t, x, y, theta]")
+        .def("covariance", &Mcl::Covariance,
+             "Row-major 3x3 covariance of (x, y, theta)")
+        .def("particles", [](Mcl& mcl){
+                 auto all = mcl.Particles();
+                 py::array_t<double> res({py::ssize_t(all.size()), py::ssize_t(4)});
+                 auto view = res.mutable_unchecked<2>();
+                 for (size_t i = 0; i < all.size(); ++i) {
+                     view(i, 0) = all[i].x;
+                     view(i, 1) = all[i].y;
+                     view(i, 2) = all[i].th;
+                     view(i, 3) = all[i].w;
+                 }
+                 return res;
+             },
+             "Copy as array[n, 4] of (x, y, theta, weight)")
+        .def_property_readonly("neff", &Mcl::EffectiveSize,
+             "Effective sample size")
+        .def_property_readonly("hits", &Mcl::Hits,
+             "Scans used for correction");
+    py::class_<ClusterTracker, ScanSink, std::shared_ptr<ClusterTracker>>(m, "Tracker")
+        .def(py::init([](double gap, double gapRatio, size_t minPoints, size_t maxPoints,
+                         double maxExtent, double minRange, double maxRange, double gate,
+                         double accel, double measurement, size_t confirmHits, size_t maxMissed,
+                         double mountX, double mountY, double mountTheta) {
+                 ClusterTracker::Params params;
+                 params.segment.gap = gap;
+                 params.segment.gapRatio = gapRatio;
+                 params.segment.minPoints = minPoints;
+                 params.segment.maxPoints = maxPoints;
+                 params.segment.maxExtent = maxExtent;
+                 params.segment.minRange = minRange;
+                 params.segment.maxRange = maxRange;
+                 params.track.gate = gate;
+                 params.track.accel = accel;
+                 params.track.measurement = measurement;
+                 params.track.confirmHits = confirmHits;
+                 params.track.maxMissed = maxMissed;
+                 params.mountX = mountX;
+                 params.mountY = mountY;
+                 params.mountTh = mountTheta;
+                 return std::make_shared<ClusterTracker>(params);
+             }),
+             "Clusters scans by polar adjacency and tracks them with constant velocity Kalman filters",
+             "gap"_a = 0.1, "gap_ratio"_a = 3., "min_points"_a = 3, "max_points"_a = 400,
+             "max_extent"_a = 1.5, "min_range"_a = 0.05, "max_range"_a = 12., "gate"_a = 0.5,
+             "accel"_a = 2., "measurement"_a = 0.05, "confirm_hits"_a = 3, "max_missed"_a = 5,
+             "mount_x"_a = 0., "mount_y"_a = 0., "mount_theta"_a = 0.)
+        .def("attach_pose", [](ClusterTracker& tracker, std::shared_ptr<Icp> icp){
+                 tracker.AttachPose([icp]{ return icp->Current(); });
+             },
+             "Track in the frame of Icp's pose",
+             "source"_a)
+        .def("attach_pose", [](ClusterTracker& tracker, std::shared_ptr<Mcl> mcl){
+                 tracker.AttachPose([mcl]{ return mcl->Current(); });
+             },
+             "Track in the map frame of Mcl",
+             "source"_a)
+        .def("attach_pose", [](ClusterTracker& tracker, std::shared_ptr<Odometry> odom){
+                 tracker.AttachPose([odom]{ return odom->Current(); });
+             },
+             "Track in the frame of arduino.Odometry",
+             "source"_a)
+        .def("clusters", [](ClusterTracker& tracker){
+                 auto all = tracker.Clusters();
+                 py::list res(all.size());
+                 for (size_t i = 0; i < all.size(); ++i) {
+                     auto& c = all[i];
+                     res[i] = py::make_tuple(c.x, c.y, c.extent, c.count, c.intensity);
+                 }
+                 return res;
+             },
+             "Latest clusters, sensor frame, as list[tuple[x, y, extent, count, intensity]]")
+        .def("tracks", [](ClusterTracker& tracker, bool confirmedOnly){
+                 auto all = tracker.Tracks();
+                 py::list res;
+                 for (auto& tr: all) {
+                     if (confirmedOnly && !tr.confirmed) {
+                         continue;
+                     }
+                     res.append(py::make_tuple(tr.id, tr.s[0], tr.s[1], tr.s[2], tr.s[3], tr.extent, tr.age));
+                 }
+                 return res;
+             },
+             "Tracks as list[tuple[id, x, y, vx, vy, extent, age]]",
+             "confirmed"_a = true)
+        .def_property_readonly("hits", &ClusterTracker::Hits,
+             "Scans consumed");
+    py::class_<LineExtractor, ScanSink, std::shared_ptr<LineExtractor>>(m, "Lines")
+        .def(py::init([](double gap, double gapRatio, double splitDist, double mergeAngle,
+                         double mergeDist, size_t minPoints, double minLength, double sigma,
+                         double cornerDist, double cornerAngle, double minRange, double maxRange) {
+                 LineExtractor::Params params;
+                 params.gap = gap;
+                 params.gapRatio = gapRatio;
+                 params.splitDist = splitDist;
+                 params.mergeAngle = mergeAngle;
+                 params.mergeDist = mergeDist;
+                 params.minPoints = minPoints;
+                 params.minLength = minLength;
+                 params.sigma = sigma;
+                 params.cornerDist = cornerDist;
+                 params.cornerAngle = cornerAngle;
+                 params.minRange = minRange;
+                 params.maxRange = maxRange;
+                 return std::make_shared<LineExtractor>(params);
+             }),
+             "Split-and-merge line segments and corners of every scan, sensor frame",
+             "gap"_a = 0.1, "gap_ratio"_a = 3., "split_dist"_a = 0.03, "merge_angle"_a = 3 * M_PI / 180,
+             "merge_dist"_a = 0.05, "min_points"_a = 6, "min_length"_a = 0.15, "sigma"_a = 0.01,
+             "corner_dist"_a = 0.15, "corner_angle"_a = 30 * M_PI / 180, "min_range"_a = 0.05,
+             "max_range"_a = 12.)
+        .def("lines", [](LineExtractor& extractor){
+                 auto all = extractor.Lines();
+                 py::list res(all.size());
+                 for (size_t i = 0; i < all.size(); ++i) {
+                     auto& l = all[i];
+                     res[i] = py::make_tuple(l.x0, l.y0, l.x1, l.y1, l.alpha, l.r, l.count,
+                                             l.varAlpha, l.varR, l.covAlphaR);
+                 }
+                 return res;
+             },
+             "Latest segments as list[tuple[x0, y0, x1, y1, alpha, r, count, var_alpha, var_r, cov_alpha_r]]")
+        .def("corners", [](LineExtractor& extractor){
+                 auto all = extractor.Corners();
+                 py::list res(all.size());
+                 for (size_t i = 0; i < all.size(); ++i) {
+                     auto& c = all[i];
+                     res[i] = py::make_tuple(c.x, c.y, c.angle, c.a, c.b);
+                 }
+                 return res;
+             },
+             "Latest corners as list[tuple[x, y, angle, line_a, line_b]]")
+        .def_property_readonly("hits", &LineExtractor::Hits,
+             "Scans consumed");
+    py::class_<ReflectorLocator, ScanSink, std::shared_ptr<ReflectorLocator>>(m, "Reflectors")
+        .def(py::init([](double minIntensity, size_t maxHoles, size_t minPoints, double minWidth,
+                         double maxWidth, double radius, double gate, double pairTolerance,
+                         size_t minInliers, size_t maxCandidates, double minRange, double maxRange,
+                         double mountX, double mountY, double mountTheta) {
+                 ReflectorLocator::Params params;
+                 params.minIntensity = minIntensity;
+                 params.maxHoles = maxHoles;
+                 params.minPoints = minPoints;
+                 params.minWidth = minWidth;
+                 params.maxWidth = maxWidth;
+                 params.radius = radius;
+                 params.gate = gate;
+                 params.pairTolerance = pairTolerance;
+                 params.minInliers = minInliers;
+                 params.maxCandidates = maxCandidates;
+                 params.minRange = minRange;
+                 params.maxRange = maxRange;
+                 params.mountX = mountX;
+                 params.mountY = mountY;
+                 params.mountTh = mountTheta;
+                 return std::make_shared<ReflectorLocator>(params);
+             }),
+             "Retro-reflector detection by intensity and pose triangulation against set_landmarks()",
+             "min_intensity"_a = 40., "max_holes"_a = 1, "min_points"_a = 2, "min_width"_a = 0.01,
+             "max_width"_a = 0.2, "radius"_a = 0., "gate"_a = 0.15, "pair_tolerance"_a = 0.05,
+             "min_inliers"_a = 2, "max_candidates"_a = 8, "min_range"_a = 0.05, "max_range"_a = 12.,
+             "mount_x"_a = 0., "mount_y"_a = 0., "mount_theta"_a = 0.)
+        .def("set_landmarks", [](ReflectorLocator& locator, vector<std::pair<double, double>> const& marks){
+                 vector<ReflectorLocator::Landmark> all;
+                 for (auto& [x, y]: marks) {
+                     all.push_back({x, y});
+                 }
+                 locator.SetLandmarks(std::move(all));
+             },
+             "Landmark map as list[tuple[x, y]], meters",
+             "landmarks"_a)
+        .def("reflectors", [](ReflectorLocator& locator){
+                 auto all = locator.Reflectors();
+                 py::list res(all.size());
+                 for (size_t i = 0; i < all.size(); ++i) {
+                     auto& r = all[i];
+                     res[i] = py::make_tuple(r.x, r.y, r.range, r.bearing, r.width, r.intensity, r.count,
+                                             r.landmark >= 0 ? py::object(py::int_(r.landmark)) : py::object(py::none()));
+                 }
+                 return res;
+             },
+             "Latest reflectors, sensor frame, as list[tuple[x, y, range, bearing, width, intensity, count, landmark]]")
+        .def("candidates", [](ReflectorLocator& locator){
+                 auto all = locator.Candidates();
+                 py::list res(all.size());
+                 for (size_t i = 0; i < all.size(); ++i) {
+                     auto& c = all[i];
+                     res[i] = py::make_tuple(c.x, c.y, c.th, c.inliers, c.rmse);
+                 }
+                 return res;
+             },
+             "Robot poses of the latest scan, best first, as list[tuple[x, y, theta, inliers, rmse]]")
+        .def_property_readonly("hits", &ReflectorLocator::Hits,
+             "Scans consumed");
+    py::class_<TemporalFilter, ScanSink, std::shared_ptr<TemporalFilter>>(m, "Temporal")
+        .def(py::init([](size_t bins, size_t depth, string const& mode, size_t minHits,
+                         double tolerance, double minRange, double maxRange) {
+                 TemporalFilter::Params params;
+                 params.bins = bins;
+                 params.depth = depth;
+                 if (mode == "median") {
+                     params.mode = TemporalFilter::Median;
+                 } else if (mode == "min") {
+                     params.mode = TemporalFilter::Min;
+                 } else {
+                     throw Err("Temporal: mode must be 'median' or 'min', got: {}", mode);
+                 }
+                 params.minHits = minHits;
+                 params.tolerance = tolerance;
+                 params.minRange = minRange;
+                 params.maxRange = maxRange;
+                 return std::make_shared<TemporalFilter>(params);
+             }),
+             "Per-angle median or min over the last depth scans, with single-scan ghost flags",
+             "bins"_a = 720, "depth"_a = 5, "mode"_a = "median", "min_hits"_a = 2, "tolerance"_a = 0.1,
+             "min_range"_a = 0.05, "max_range"_a = 12.)
+        .def("ranges", [](TemporalFilter& filter){
+                 auto all = filter.Ranges();
+                 return py::array_t<float>(py::ssize_t(all.size()), all.data());
+             },
+             "Filtered float array[bins], bin i centered at (i + 0.5) * 2pi / bins, 0 for no return")
+        .def("binned", [](TemporalFilter& filter){
+                 auto all = filter.Binned();
+                 return py::array_t<float>(py::ssize_t(all.size()), all.data());
+             },
+             "Latest scan binned as ranges(), unfiltered")
+        .def("ghosts", [](TemporalFilter& filter){
+                 auto all = filter.Ghosts();
+                 return py::array_t<bool>(py::ssize_t(all.size()), reinterpret_cast<bool*>(all.data()));
+             },
+             "Bool array[bins], set where the latest return was not seen in any other scan of the window")
+        .def_property_readonly("bins", &TemporalFilter::Bins)
+        .def_property_readonly("hits", &TemporalFilter::Hits,
+             "Scans consumed");
+    py::class_<Downsample, ScanSink, std::shared_ptr<Downsample>>(m, "Downsample")
+        .def(py::init([](double voxel, double spacing, double minRange) {
+                 Downsampler::Params params;
+                 params.voxel = voxel;
+                 params.spacing = spacing;
+                 params.minRange = minRange;
+                 return std::make_shared<Downsample>(params);
+             }),
+             "Feeds an index view of every scan to its own sinks: first node per voxel, "
+             "or nodes at least spacing apart. Set one of voxel and spacing, meters",
+             "voxel"_a = 0., "spacing"_a = 0., "min_range"_a = 0.05)
+        .def("attach", &Downsample::Attach,
+             "Feed the downsampled view to sink",
+             "sink"_a)
+        .def("detach", &Downsample::Detach,
+             "Stop feeding sink",
+             "sink"_a)
+        .def_property_readonly("kept", &Downsample::Kept,
+             "Nodes in the latest view")
+        .def_property_readonly("hits", &Downsample::Hits,
+             "Scans consumed");
+    m.def("feed", [](std::shared_ptr<ScanSink> sink,
+                     py::array_t<float, py::array::c_style | py::array::forcecast> data,
+                     std::optional<double> t) {
+              if (data.ndim() != 2 || data.shape(1) != 3) {
+                  throw Err("feed: data must be array[n, 3] of (range, intensity, theta)");
+              }
+              auto count = size_t(data.shape(0));
+              vector<ParsedNode> nodes(count);
+              auto raw = data.data();
+              for (size_t i = 0; i < count; ++i) {
+                  auto& node = nodes[i];
+                  node.range = raw[i * 3];
+                  node.intensity = raw[i * 3 + 1];
+                  node.relTheta = raw[i * 3 + 2];
+                  node.x = node.range * std::cos(node.relTheta);
+                  node.y = -node.range * std::sin(node.relTheta);
+              }
+              py::gil_scoped_release unlock;
+              Scan scan{nodes.data(), count, t.value_or(Scan::Now())};
+              auto started = Scan::Now();
+              sink->Consume(scan);
+              return Scan::Now() - started;
+          },
+          "Run sink on a recorded scan as passed to RP._onscan, returns seconds spent in the sink",
+          "sink"_a, "data"_a, "t"_a = py::none());
     auto cls = py::class_<lidar::rp::Driver, lidar::rp::PyDriver>(m, "RP")
-        .def(py::init<std::string>(),
-                        "Create Driver with specified device URI",
-                        py::arg("uri"))
+        .def(py::init<std::string, std::shared_ptr<bang::Reactor>>(),
+                        "Create Driver with specified device URI, optionally polled from shared reactor. "
+                        "URI params min_range, max_range, min_intensity, mask=from:to,... (degrees) and "
+                        "footprint=x:y,..., shadow_angle (degrees) and shadow_window configure the initial filter",
+                        py::arg("uri"), py::arg("reactor") = nullptr)
         .def("_onscan", &lidar::rp::Driver::_onscan,
                         "Override to handle scan data tuple[range, intensity, theta]",
                         py::arg("data"))
+        .def("attach", &lidar::rp::Driver::attach,
+                        "Feed every scan to native sink on the driver thread",
+                        py::arg("sink"))
+        .def("detach", &lidar::rp::Driver::detach,
+                        "Stop feeding sink",
+                        py::arg("sink"))
+        .def("set_filter", [](lidar::rp::Driver& driver, double minRange, double maxRange,
+                              double minIntensity, vector<std::pair<float, float>> footprint,
+                              vector<std::pair<float, float>> sectors, double shadowAngle,
+                              size_t shadowWindow) {
+                            ScanFilter::Params params;
+                            params.minRange = minRange;
+                            params.maxRange = maxRange;
+                            params.minIntensity = minIntensity;
+                            params.footprint = std::move(footprint);
+                            params.sectors = std::move(sectors);
+                            params.shadowAngle = shadowAngle;
+                            params.shadowWindow = shadowWindow;
+                            driver.setFilter(std::move(params));
+                        },
+                        "Drop nodes before sinks and _onscan: out of [min_range, max_range], below min_intensity, "
+                        "inside footprint polygon list[tuple[x, y]] (sensor frame), in sectors list[tuple[from, to]] (radians), "
+                        "or shadowed: farther of two nodes up to shadow_window (max 8) apart seen within shadow_angle (radians) "
+                        "of the line of sight",
+                        py::arg("min_range") = 0., py::arg("max_range") = INFINITY, py::arg("min_intensity") = 0.,
+                        py::arg("footprint") = vector<std::pair<float, float>>{},
+                        py::arg("sectors") = vector<std::pair<float, float>>{},
+                        py::arg("shadow_angle") = 0., py::arg("shadow_window") = 2)
+        .def("clear_filter", &lidar::rp::Driver::clearFilter,
+                        "Deliver all nodes")
+        .def("set_downsample", [](lidar::rp::Driver& driver, double voxel, double spacing, double minRange) {
+                            Downsampler::Params params;
+                            params.voxel = voxel;
+                            params.spacing = spacing;
+                            params.minRange = minRange;
+                            driver.setDownsample(params);
+                        },
+                        "Pass only a downsampled view to _onscan, attached sinks still get every node. "
+                        "Set one of voxel (meters) or spacing (meters between kept nodes)",
+                        py::arg("voxel") = 0., py::arg("spacing") = 0., py::arg("min_range") = 0.05)
+        .def("clear_downsample", &lidar::rp::Driver::clearDownsample,
+                        "Pass every node to _onscan")
         .def("error", &lidar::rp::Driver::error,
                         "Override to handle error messages",
                         py::arg("msg"));
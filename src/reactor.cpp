@@ -0,0 +1,18 @@
+#include <Python.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include "reactor.hpp"
+
+namespace py = pybind11;
+using namespace py::literals;
+using namespace bang;
+
+PYBIND11_MODULE(reactor, m) {
+    py::class_<Reactor, std::shared_ptr<Reactor>>(m, "Reactor")
+        .def(py::init<unsigned, vector<int>>(),
+             "Create io reactor to be shared between device channels",
+             "threads"_a = 1, "cpus"_a = vector<int>{},
+             py::call_guard<py::gil_scoped_release>())
+        .def("__len__", &Reactor::size,
+             "Amount of threads");
+}